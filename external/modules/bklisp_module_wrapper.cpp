@@ -42,7 +42,7 @@ Atom vv2atom(bukalisp::VM *vm, const VV &vv)
     }
     if (vv->is_string() || vv->is_bytes() || vv->is_datetime())
     {
-        return Atom(T_STR, vm->m_rt->m_gc.new_symbol(vv->s()));
+        return Atom(T_STR, vm->m_rt->m_gc.new_string(vv->s()));
     }
     else if (vv->is_undef())
         return Atom();
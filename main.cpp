@@ -17,6 +17,8 @@
 #include "atom_printer.h"
 #include "bukalisp.h"
 #include "util.h"
+#include "prog_image.h"
+#include "fork_server.h"
 #include "config.h"
 
 #if USE_MODULES
@@ -136,7 +138,7 @@ class Reader
 
         Atom a_sym(const std::string &s) { return Atom(T_SYM, m_gc.new_symbol(s)); }
         Atom a_kw(const std::string &s) { return Atom(T_KW, m_gc.new_symbol(s)); }
-        Atom a_str(const std::string &s) { return Atom(T_STR, m_gc.new_symbol(s)); }
+        Atom a_str(const std::string &s) { return Atom(T_STR, m_gc.new_string(s)); }
 
         void make_always_alive(Atom a) { m_root_set->push(a); }
 
@@ -1137,6 +1139,9 @@ int main(int argc, char *argv[])
         bool do_stat            = false;
         bool bootstrap          = false;
         bool write_compiler     = false;
+        std::string compile_cache_dir;
+        std::string heap_snapshot_path;
+        std::string fork_server_path;
 
         for (int i = 1; i < argc; i++)
         {
@@ -1162,6 +1167,12 @@ int main(int argc, char *argv[])
                 bootstrap = true;
                 write_compiler = true;
             }
+            else if (arg == "-C" && i + 1 < argc)
+                compile_cache_dir = argv[++i];
+            else if (arg == "-s" && i + 1 < argc)
+                heap_snapshot_path = argv[++i];
+            else if (arg == "--fork-server" && i + 1 < argc)
+                fork_server_path = argv[++i];
             else if (arg[0] == '-')
             {
                 std::cerr << "unknown option: " << argv[i] << std::endl;
@@ -1337,17 +1348,11 @@ int main(int argc, char *argv[])
             if (write_compiler)
             {
                 std::string bootstrapped_compiler_filepath = compiler_filepath + "c";
-                write_str(bootstrapped_compiler_filepath,
-                    expand_userdata_to_atoms(&(rt.m_gc), compiler).to_write_str(true));
-                Atom compiler_serialized_from_disk =
-                    rt.read(bootstrapped_compiler_filepath,
-                            slurp_str(bootstrapped_compiler_filepath));
-                compiler_serialized_from_disk = compiler_serialized_from_disk.at(0);
-
-                AtomMap refmap;
+                save_prog_image_file(
+                    rt.m_gc, bootstrapped_compiler_filepath, compiler);
                 compiler =
-                    PROG::repack_expanded_userdata(
-                        rt.m_gc, compiler_serialized_from_disk, &refmap);
+                    load_prog_image_file(
+                        rt.m_gc, bootstrapped_compiler_filepath);
             }
 
             compiler = vm.eval(compiler, nullptr);
@@ -1369,7 +1374,7 @@ int main(int argc, char *argv[])
                     {
                         GC_ROOT_VEC(rt.m_gc, args) = rt.m_gc.allocate_vector(4);
                         args->m_len = 4;
-                        args->m_data[0] = Atom(T_STR, rt.m_gc.new_symbol(input_name));
+                        args->m_data[0] = Atom(T_STR, rt.m_gc.new_string(input_name));
                         args->m_data[1] = prog;
                         args->m_data[2].set_map(root_env);
                         args->m_data[3].set_bool(only_compile);
@@ -1393,6 +1398,24 @@ int main(int argc, char *argv[])
                 cerr << "Exception: " << e.what() << endl;
             }
         }
+        else if (!fork_server_path.empty())
+        {
+            // The optional input file is the application code, that is
+            // loaded once into the root environment of all jobs:
+            Instance inst;
+            load_vm_modules_inst(inst);
+
+            if (   heap_snapshot_path.empty()
+                || !inst.load_heap_snapshot(heap_snapshot_path))
+                inst.load_bootstrapped_compiler_from_disk();
+
+            Runtime &rt = inst.get_runtime();
+            GC_ROOT_MAP(rt.m_gc, root_env) = rt.m_gc.allocate_map();
+            if (!input_file_path.empty())
+                inst.execute_file(input_file_path, root_env);
+
+            run_fork_server(inst, fork_server_path, root_env);
+        }
         else if (!input_file_path.empty())
         {
             Instance inst;
@@ -1400,7 +1423,14 @@ int main(int argc, char *argv[])
 
             try
             {
-                inst.load_bootstrapped_compiler_from_disk();
+                if (   heap_snapshot_path.empty()
+                    || !inst.load_heap_snapshot(heap_snapshot_path))
+                {
+                    inst.load_bootstrapped_compiler_from_disk();
+                    if (!heap_snapshot_path.empty())
+                        inst.save_heap_snapshot(heap_snapshot_path);
+                }
+                inst.set_compile_cache_dir(compile_cache_dir);
 
                 BenchmarkTimer bt;
                 inst.get_runtime().m_tok.set_trace(i_trace_tok);
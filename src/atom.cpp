@@ -21,9 +21,9 @@ size_t AtomVec::s_alloc_count = 0;
 const size_t HASH_TABLE_SIZES[] = {
     7,          // Used only by "bklisp tests"
     11,         // Used only by "bklisp tests"
-    23,         // Used only by "bklisp tests"
-    53,         // First size the table actually grows to, as the
-    97,         // initial included table size is 23!
+    23,         // First size of the hashed table, smaller maps
+    53,         // use the linear small representation.
+    97,
     193,
     389,
     769,
@@ -55,6 +55,23 @@ const size_t HASH_TABLE_SIZES[] = {
 thread_local MemoryPool<Atom> g_atom_array_pool;
 #endif
 
+thread_local GCRememberedSet g_gc_remembered;
+
+//---------------------------------------------------------------------------
+
+void gc_remember(AtomVec *vec)
+{
+    vec->m_gc_gen |= GC_GEN_REMEMBERED;
+    g_gc_remembered.m_vecs.push_back(vec);
+}
+//---------------------------------------------------------------------------
+
+void gc_remember(AtomMap *map)
+{
+    map->m_gc_gen |= GC_GEN_REMEMBERED;
+    g_gc_remembered.m_maps.push_back(map);
+}
+
 //---------------------------------------------------------------------------
 
 size_t count_elements(const Atom &a)
@@ -344,6 +361,8 @@ size_t AtomHash::operator()(const Atom &a) const
         case T_SYNTAX:
         case T_SYM:
         case T_KW:
+            return a.m_d.sym->m_hash;
+
         case T_STR:
             return std::hash<std::string>()(a.m_d.sym->m_str);
 
@@ -445,6 +464,7 @@ void AtomVec::set(size_t idx, const Atom &a)
         check_size(idx);
 //    std::cout << "SET @(" << idx << ")" << ((void *) m_data) << std::endl;
     m_data[idx] = a;
+    gc_write_barrier(this);
 }
 //---------------------------------------------------------------------------
 
@@ -454,6 +474,7 @@ void AtomVec::push(const Atom &a)
     check_size(new_idx);
 //    std::cout << "PUSH @(" << new_idx << ")" << ((void *) m_data) << std::endl;
     m_data[new_idx] = a;
+    gc_write_barrier(this);
 }
 //---------------------------------------------------------------------------
 
@@ -464,6 +485,7 @@ void AtomVec::unshift(const Atom &a)
     for (size_t i = new_idx; i > 0; i--)
         m_data[i] = m_data[i - 1];
     m_data[0] = a;
+    gc_write_barrier(this);
 }
 //---------------------------------------------------------------------------
 
@@ -566,14 +588,29 @@ Atom GC::get_statistics()
 #define     BKLISP_GC_NEW_ST_ENTRY_STR(name, str) \
     e = this->allocate_vector(0); \
     e->push(Atom(T_KW,  this->new_symbol(name))); \
-    e->push(Atom(T_STR, this->new_symbol(str))); \
+    e->push(Atom(T_STR, this->new_string(str))); \
     v->push(Atom(T_VEC, e));
 
     BKLISP_GC_NEW_ST_ENTRY("alive-vectors", m_num_alive_vectors);
     BKLISP_GC_NEW_ST_ENTRY("alive-maps",    m_num_alive_maps);
     BKLISP_GC_NEW_ST_ENTRY("alive-syms",    m_num_alive_syms);
+    BKLISP_GC_NEW_ST_ENTRY("alive-strings", m_num_alive_strings);
+    BKLISP_GC_NEW_ST_ENTRY("string-bytes",  m_string_bytes);
+    BKLISP_GC_NEW_ST_ENTRY("young-vectors", m_num_new_vectors);
+    BKLISP_GC_NEW_ST_ENTRY("young-maps",    m_num_new_maps);
+    BKLISP_GC_NEW_ST_ENTRY("remembered",
+        g_gc_remembered.m_vecs.size() + g_gc_remembered.m_maps.size());
+    BKLISP_GC_NEW_ST_ENTRY("minor-collections", m_num_minor_collections);
+    BKLISP_GC_NEW_ST_ENTRY("major-collections", m_num_major_collections);
+    BKLISP_GC_NEW_ST_ENTRY("mark-steps",        m_num_mark_steps);
+    BKLISP_GC_NEW_ST_ENTRY("mark-threads",      m_mark_threads);
+    BKLISP_GC_NEW_ST_ENTRY("lazy-swept",        m_num_lazy_swept);
+    BKLISP_GC_NEW_ST_ENTRY("heap-bytes",        heap_bytes());
+    BKLISP_GC_NEW_ST_ENTRY("heap-target-bytes", m_heap_target_bytes);
+    BKLISP_GC_NEW_ST_ENTRY("frozen-objects",    num_frozen_objects());
 
     size_t n_alive_vector_bytes = 0;
+    size_t n_sweep_pending      = 0;
     AtomVec *alive_v = m_vectors;
     while (alive_v)
     {
@@ -581,6 +618,19 @@ Atom GC::get_statistics()
             sizeof(AtomVec) + alive_v->m_alloc * sizeof(Atom);
         alive_v = alive_v->m_gc_next;
     }
+    alive_v = m_unswept_vectors;
+    while (alive_v)
+    {
+        n_alive_vector_bytes +=
+            sizeof(AtomVec) + alive_v->m_alloc * sizeof(Atom);
+        n_sweep_pending++;
+        alive_v = alive_v->m_gc_next;
+    }
+    for (AtomMap *m = m_unswept_maps; m; m = m->m_gc_next)
+        n_sweep_pending++;
+    for (UserData *ud = m_unswept_userdata; ud; ud = ud->m_gc_next)
+        n_sweep_pending++;
+    BKLISP_GC_NEW_ST_ENTRY("sweep-pending", n_sweep_pending);
 
     size_t n_syms_size = 0;
     Sym *s = m_syms;
@@ -653,9 +703,9 @@ RegRowsReference::RegRowsReference(
 void RegRowsReference::mark(GC *gc, uint8_t clr)
 {
     UserData::mark(gc, clr);
-    gc->mark_atom(Atom(T_VEC, *m_rr0));
-    gc->mark_atom(Atom(T_VEC, *m_rr1));
-    gc->mark_atom(Atom(T_VEC, *m_rr2));
+    gc->mark_reg_row(*m_rr0);
+    gc->mark_reg_row(*m_rr1);
+    gc->mark_reg_row(*m_rr2);
 }
 //---------------------------------------------------------------------------
 
@@ -715,9 +765,9 @@ Atom BukaLISPException::create_error_object(GC &gc) const
 {
     AtomVec *err_obj = gc.allocate_vector(5);
     err_obj->push(Atom(T_SYM, gc.new_symbol("BKL-ERROR-OBJ")));
-    err_obj->push(Atom(T_STR, gc.new_symbol(get_error_message())));
+    err_obj->push(Atom(T_STR, gc.new_string(get_error_message())));
     err_obj->push(get_error_obj());
-    err_obj->push(Atom(T_STR, gc.new_symbol(what())));
+    err_obj->push(Atom(T_STR, gc.new_string(what())));
 
     AtomVec *frms = gc.allocate_vector(10);
     err_obj->push(Atom(T_VEC, frms));
@@ -729,10 +779,10 @@ Atom BukaLISPException::create_error_object(GC &gc) const
             const std::string &func_name)
         {
             AtomVec *frm = gc.allocate_vector(4);
-            frm->push(Atom(T_STR, gc.new_symbol(place)));
-            frm->push(Atom(T_STR, gc.new_symbol(file_name)));
+            frm->push(Atom(T_STR, gc.new_string(place)));
+            frm->push(Atom(T_STR, gc.new_string(file_name)));
             frm->push(Atom(T_INT, line));
-            frm->push(Atom(T_STR, gc.new_symbol(func_name)));
+            frm->push(Atom(T_STR, gc.new_string(func_name)));
             frms->push(Atom(T_VEC, frm));
         });
 
@@ -10,7 +10,10 @@
 #include <string>
 #include <functional>
 #include <memory>
+#include <algorithm>
+#include <chrono>
 #include "atom_userdata.h"
+#include "gc_parallel_mark.h"
 
 #if WITH_MEM_POOL
 #include "mempool.h"
@@ -157,6 +160,10 @@ struct Sym
     uint8_t     m_gc_color;
     Sym        *m_gc_next;
     std::string m_str;
+    // Hash of m_str, set once when a symbol or keyword is interned.
+    // It depends only on the text, so it stays the same if the
+    // symbol is swept and interned again. Unused for T_STR.
+    size_t      m_hash;
 };
 //---------------------------------------------------------------------------
 
@@ -164,9 +171,33 @@ struct Atom;
 
 struct AtomVec;
 
+#define GC_COLOR_FREE    0x08
+#define GC_COLOR_DELETE  0x04
+#define GC_COLOR_WHITE   0x01
+#define GC_COLOR_BLACK   0x00
+// Color of objects, that are not allocated by a GC (like vectors on
+// the C++ stack):
+#define GC_COLOR_UNMANAGED 0xFE
+// Marker for GCRememberedSet::m_black_color, no object has this color:
+#define GC_COLOR_NONE      0xFF
+// Objects that were made permanent by GC::freeze(). Their mark bits are
+// kept in GCSideMarks, indexed by m_gc_side_idx of the object:
+#define GC_COLOR_FROZEN    0x10
+
+// Generation flags of vectors, maps and userdata (m_gc_gen).
+// New objects are allocated in the nursery (GC_GEN_YOUNG) and are
+// promoted to GC_GEN_OLD, when they survive a minor collection.
+// Old objects that were written to since the last minor collection
+// are also GC_GEN_REMEMBERED (see gc_write_barrier()).
+#define GC_GEN_YOUNG       0x00
+#define GC_GEN_OLD         0x01
+#define GC_GEN_REMEMBERED  0x02
+
 struct AtomVec
 {
     uint8_t     m_gc_color;
+    uint8_t     m_gc_gen;
+    uint32_t    m_gc_side_idx;
     AtomVec    *m_gc_next;
 
     size_t      m_alloc;
@@ -177,7 +208,8 @@ struct AtomVec
     static size_t   s_alloc_count;
 
     AtomVec()
-        : m_gc_next(nullptr), m_gc_color(0), m_alloc(0),
+        : m_gc_next(nullptr), m_gc_color(GC_COLOR_UNMANAGED), m_gc_gen(GC_GEN_YOUNG),
+          m_gc_side_idx(0), m_alloc(0),
           m_len(0), m_data(nullptr), m_meta(nullptr)
     {
         s_alloc_count++;
@@ -233,7 +265,8 @@ struct Atom
         int64_t      i;
         double       d;
         bool         b;
-        struct { size_t key; size_t idx; } hpair;
+        // Kept at 8 bytes, so that an Atom is only 16 bytes:
+        struct { uint32_t key; uint32_t idx; } hpair;
 
         PrimFunc    *func;
         Sym         *sym;
@@ -354,7 +387,7 @@ struct Atom
         m_d.b = b;
     }
 
-    void set_hpair(size_t key, size_t idx)
+    void set_hpair(uint32_t key, uint32_t idx)
     {
         m_type = T_HPAIR;
         m_d.hpair.key = key;
@@ -461,8 +494,9 @@ struct Atom
         {
             case T_KW:
             case T_SYM:
-            case T_STR:
             case T_SYNTAX: return m_d.sym  == o.m_d.sym;
+            case T_STR:    return    m_d.sym == o.m_d.sym
+                                  || m_d.sym->m_str == o.m_d.sym->m_str;
             case T_CLOS:
             case T_VEC:    return m_d.vec  == o.m_d.vec;
             case T_MAP:    return m_d.map  == o.m_d.map;
@@ -525,6 +559,9 @@ struct Atom
             case T_BOOL: return m_d.b == other.m_d.b;
 
             case T_STR:
+                return    m_d.sym == other.m_d.sym
+                       || m_d.sym->m_str == other.m_d.sym->m_str;
+
             case T_KW:
             case T_SYNTAX:
             case T_SYM:
@@ -554,10 +591,148 @@ struct Atom
 };
 //---------------------------------------------------------------------------
 
-#define GC_COLOR_FREE    0x08
-#define GC_COLOR_DELETE  0x04
-#define GC_COLOR_WHITE   0x01
-#define GC_COLOR_BLACK   0x00
+/* The remembered set of the generational GC. It holds the old vectors
+ * and maps, that were written to since the last minor collection and
+ * thus might point into the nursery. It is per thread, like
+ * g_atom_array_pool, so the write barrier does not need to know the
+ * GC an object belongs to.
+ *
+ * While an incremental mark is running, m_black_color is the color of
+ * the already marked objects. Writes to those objects are remembered too
+ * and the objects are scanned again before the sweep, so a black object
+ * never keeps an unmarked object alive unnoticed.
+ */
+struct GCRememberedSet
+{
+    std::vector<AtomVec *> m_vecs;
+    std::vector<AtomMap *> m_maps;
+    uint8_t                m_black_color = GC_COLOR_NONE;
+};
+
+thread_local extern GCRememberedSet g_gc_remembered;
+
+/* Mark bits of the frozen objects (see GC::freeze()).
+ *
+ * They are kept out of the object headers, so that marking does not
+ * write to the pages of the frozen heap. After a fork() those pages
+ * stay shared with the parent process.
+ */
+struct GCSideMarks
+{
+    std::vector<uint64_t> m_bits;
+
+    void resize(size_t num_bits) { m_bits.resize((num_bits + 63) / 64, 0); }
+    void clear() { std::fill(m_bits.begin(), m_bits.end(), 0); }
+
+    bool test(uint32_t idx) const
+    {
+        return (m_bits[idx >> 6] >> (idx & 63)) & 1;
+    }
+
+    // Returns true if the bit was not set before:
+    bool set(uint32_t idx)
+    {
+        uint64_t  bit  = ((uint64_t) 1) << (idx & 63);
+        uint64_t &word = m_bits[idx >> 6];
+        if (word & bit)
+            return false;
+        word |= bit;
+        return true;
+    }
+};
+
+void gc_remember(AtomVec *vec);
+void gc_remember(AtomMap *map);
+
+inline void gc_write_barrier(AtomVec *vec)
+{
+    if (   vec->m_gc_gen == GC_GEN_OLD
+        || (   vec->m_gc_color == g_gc_remembered.m_black_color
+            && !(vec->m_gc_gen & GC_GEN_REMEMBERED)))
+        gc_remember(vec);
+}
+
+inline void gc_write_barrier(AtomMap *map)
+{
+    if (   map->m_gc_gen == GC_GEN_OLD
+        || (   map->m_gc_color == g_gc_remembered.m_black_color
+            && !(map->m_gc_gen & GC_GEN_REMEMBERED)))
+        gc_remember(map);
+}
+
+// The VM writes to its current register rows without write barrier,
+// so they are remembered when they become current. While an incremental
+// mark is running, this is done regardless of their color, because
+// they might be marked while the VM still writes to them.
+inline void gc_reg_row_barrier(AtomVec *row)
+{
+    if (   row->m_gc_gen == GC_GEN_OLD
+        || (   g_gc_remembered.m_black_color != GC_COLOR_NONE
+            && !(row->m_gc_gen & GC_GEN_REMEMBERED)))
+        gc_remember(row);
+}
+//---------------------------------------------------------------------------
+
+// Sweeps the nursery after a minor collection. Objects that were
+// promoted by the marking are moved to old_list, the others are freed.
+template<typename T>
+void gc_list_sweep_young(T *young, T *&old_list, size_t &num_promoted, std::function<void(T *)> free_func)
+{
+    num_promoted = 0;
+
+    while (young)
+    {
+        T *cur = young;
+        young = cur->m_gc_next;
+
+        if (!(cur->m_gc_gen & GC_GEN_OLD))
+        {
+            free_func(cur);
+            continue;
+        }
+
+        cur->m_gc_next = old_list;
+        old_list = cur;
+        num_promoted++;
+    }
+}
+//---------------------------------------------------------------------------
+
+// Appends the survivors of the nursery to old_list after a major collection.
+template<typename T>
+T *gc_list_promote(T *young, T *old_list)
+{
+    while (young)
+    {
+        T *cur = young;
+        young = cur->m_gc_next;
+
+        cur->m_gc_gen |= GC_GEN_OLD;
+        cur->m_gc_next = old_list;
+        old_list = cur;
+    }
+
+    return old_list;
+}
+//---------------------------------------------------------------------------
+
+// Moves all objects of list to the front of frozen, see GC::freeze().
+template<typename T>
+T *gc_list_freeze(T *list, T *frozen, std::function<void(T *)> freeze_func)
+{
+    while (list)
+    {
+        T *cur = list;
+        list = cur->m_gc_next;
+
+        freeze_func(cur);
+        cur->m_gc_color = GC_COLOR_FROZEN;
+        cur->m_gc_next  = frozen;
+        frozen = cur;
+    }
+
+    return frozen;
+}
 //---------------------------------------------------------------------------
 
 template<typename T>
@@ -586,6 +761,35 @@ T *gc_list_sweep(T *list, size_t &num_alive, uint8_t current_color, std::functio
 }
 //---------------------------------------------------------------------------
 
+// Sweeps at most max_work objects from the front of unswept. The
+// survivors are moved to alive_list. Returns the number of objects
+// that were swept, the number of freed ones is added to num_freed.
+template<typename T>
+size_t gc_list_sweep_some(T *&unswept, T *&alive_list, size_t max_work, uint8_t current_color, size_t &num_freed, std::function<void(T *)> free_func)
+{
+    size_t work = 0;
+
+    while (unswept && work < max_work)
+    {
+        T *cur = unswept;
+        unswept = cur->m_gc_next;
+        work++;
+
+        if (cur->m_gc_color != current_color)
+        {
+            free_func(cur);
+            num_freed++;
+            continue;
+        }
+
+        cur->m_gc_next = alive_list;
+        alive_list = cur;
+    }
+
+    return work;
+}
+//---------------------------------------------------------------------------
+
 class AtomVecPush
 {
     private:
@@ -744,9 +948,55 @@ class GC
         AtomMap         *m_maps;
         UserData        *m_userdata;
         Sym             *m_syms;
+        // Strings are Sym objects too, but they are not interned
+        // in m_symtbl, see new_string():
+        Sym             *m_strings;
         GCRootRefPool   m_root_pool;
 
+        // The nursery, new objects are allocated here and are moved
+        // to the lists above when they survive a collection:
+        AtomVec         *m_young_vectors;
+        AtomMap         *m_young_maps;
+        UserData        *m_young_userdata;
+
+        // Old objects, that were not swept since the last major
+        // collection. They are swept in steps, see sweep_step():
+        AtomVec         *m_unswept_vectors;
+        AtomMap         *m_unswept_maps;
+        UserData        *m_unswept_userdata;
+
+        // Objects made permanent by freeze(). They are never swept
+        // and are marked in m_side_marks instead of their headers:
+        AtomVec         *m_frozen_vectors;
+        AtomMap         *m_frozen_maps;
+        UserData        *m_frozen_userdata;
+        Sym             *m_frozen_syms;
+        Sym             *m_frozen_strings;
+        GCSideMarks      m_side_marks;
+        uint32_t         m_num_side_marks;
+        // Frozen objects that were written since the freeze. They might
+        // refer to objects that are not frozen. Frozen objects are never
+        // freed, so they are roots of each major collection (together
+        // with the frozen userdata), see mark_frozen_roots():
+        GCSideMarks             m_frozen_dirty;
+        std::vector<AtomVec *>  m_frozen_dirty_vecs;
+        std::vector<AtomMap *>  m_frozen_dirty_maps;
+
         uint8_t  m_current_color;
+        // Color of new vectors and maps, during an incremental mark
+        // they are allocated unmarked:
+        uint8_t  m_alloc_color;
+        // true while a minor collection is marking:
+        bool     m_minor;
+        // true while an incremental mark is in progress,
+        // see start_incremental_mark():
+        bool     m_inc_marking;
+        // Time budget of one mark_step(), 0 disables incremental marking:
+        size_t   m_pause_budget_us;
+        // Number of threads that mark a full collection, see mark():
+        size_t   m_mark_threads;
+
+        std::unique_ptr<GCParallelMarker> m_par_marker;
 
         std::vector<Sym *>              m_perm_syms;
         StrSymMap                       m_symtbl;
@@ -769,6 +1019,10 @@ class GC
         size_t       m_num_medium_vectors;
 
         size_t       m_num_alive_syms;
+        size_t       m_num_alive_strings;
+        size_t       m_num_new_strings;
+        // Characters of all strings, for heap_bytes():
+        size_t       m_string_bytes;
         size_t       m_num_alive_vectors;
         size_t       m_num_alive_maps;
         size_t       m_num_alive_userdata;
@@ -776,6 +1030,34 @@ class GC
         size_t       m_num_new_vectors;
         size_t       m_num_new_maps;
         size_t       m_num_new_userdata;
+        size_t       m_num_promoted_vectors;
+        size_t       m_num_promoted_maps;
+        size_t       m_num_promoted_userdata;
+        size_t       m_num_frozen_vectors;
+        size_t       m_num_frozen_maps;
+        size_t       m_num_frozen_userdata;
+        size_t       m_num_frozen_syms;
+        size_t       m_num_frozen_strings;
+
+        size_t       m_num_minor_collections;
+        size_t       m_num_major_collections;
+        size_t       m_num_mark_steps;
+        // Old objects that were swept by sweep_step() instead of
+        // in the pause of a major collection:
+        size_t       m_num_lazy_swept;
+
+        // The heap may grow to m_heap_growth times the bytes that
+        // survived the last major collection, but not below
+        // m_heap_min_bytes and (softly) not beyond
+        // m_heap_soft_limit_bytes. See update_heap_target().
+        double       m_heap_growth;
+        size_t       m_heap_min_bytes;
+        size_t       m_heap_soft_limit_bytes;
+        size_t       m_heap_target_bytes;
+
+        // Remembered objects that were freed by the sweep,
+        // see forget_freed_remembered():
+        std::vector<void *> m_freed_remembered;
 
         void allocate_new_vectors(AtomVec *&list, size_t &num, size_t len)
         {
@@ -805,16 +1087,27 @@ class GC
         {
             if (!map) return;
 
-            if (map->m_gc_color == m_current_color)
-                return;
-
 #           if GC_DEBUG_MODE
                 if (map->m_gc_color == GC_COLOR_FREE)
                     throw BukaLISPException("Major GC rooting bug: GC marking free or deleted vector");
 #           endif
 
-            map->m_gc_color = m_current_color;
+            if (m_minor)
+            {
+                // Old maps are only scanned if they are remembered,
+                // see mark_minor():
+                if (map->m_gc_gen & GC_GEN_OLD)
+                    return;
+                map->m_gc_gen |= GC_GEN_OLD;
+            }
+            else if (!set_mark(map))
+                return;
+
+            scan_map(map);
+        }
 
+        void scan_map(AtomMap *map)
+        {
             ATOM_MAP_FOR(i, map)
             {
                 mark_atom(MAP_ITER_KEY(i));
@@ -825,8 +1118,31 @@ class GC
                 m_gc_vec_stack.push_back(map->m_meta);
         }
 
-        void mark()
+        // Marks obj for the current major collection, returns false
+        // if it was marked already:
+        template<typename T>
+        bool set_mark(T *obj)
+        {
+            if (obj->m_gc_color == GC_COLOR_FROZEN)
+                return m_side_marks.set(obj->m_gc_side_idx);
+            if (obj->m_gc_color == m_current_color)
+                return false;
+            obj->m_gc_color = m_current_color;
+            return true;
+        }
+
+        template<typename T>
+        bool is_marked(T *obj) const
         {
+            if (obj->m_gc_color == GC_COLOR_FROZEN)
+                return m_side_marks.test(obj->m_gc_side_idx);
+            return obj->m_gc_color == m_current_color;
+        }
+
+        void mark_begin()
+        {
+            finish_sweep();
+
             m_current_color =
                 m_current_color == GC_COLOR_WHITE
                 ? GC_COLOR_BLACK
@@ -835,13 +1151,212 @@ class GC
 //            std::cout << "* GC MARK CLR = " << ((int) m_current_color) << std::endl;
 
             for (auto &sym : m_perm_syms)
-                sym->m_gc_color = m_current_color;
+                if (sym->m_gc_color != GC_COLOR_FROZEN)
+                    sym->m_gc_color = m_current_color;
+
+            m_side_marks.clear();
 
             m_gc_vec_stack.clear();
             m_gc_map_stack.clear();
 
             m_gc_vec_stack.push_back(m_root_pool.get_pool());
+            mark_frozen_roots();
+        }
+
+        // Records the frozen objects in the remembered set as dirty.
+        // The remembered set is shared by the GCs of a thread, so only
+        // one of them may be frozen.
+        void note_dirty_frozen()
+        {
+            if (m_num_side_marks == 0)
+                return;
+
+            for (auto vec : g_gc_remembered.m_vecs)
+                if (   vec->m_gc_color == GC_COLOR_FROZEN
+                    && vec->m_gc_side_idx < m_num_side_marks
+                    && m_frozen_dirty.set(vec->m_gc_side_idx))
+                    m_frozen_dirty_vecs.push_back(vec);
+
+            for (auto map : g_gc_remembered.m_maps)
+                if (   map->m_gc_color == GC_COLOR_FROZEN
+                    && map->m_gc_side_idx < m_num_side_marks
+                    && m_frozen_dirty.set(map->m_gc_side_idx))
+                    m_frozen_dirty_maps.push_back(map);
+        }
 
+        // Frozen objects stay alive even if they are unreachable, so
+        // whatever they refer to has to stay alive too. Otherwise a
+        // minor collection would scan a freed object through them.
+        void mark_frozen_roots()
+        {
+            note_dirty_frozen();
+
+            for (auto vec : m_frozen_dirty_vecs)
+                m_gc_vec_stack.push_back(vec);
+            for (auto map : m_frozen_dirty_maps)
+                m_gc_map_stack.push_back(map);
+
+            for (UserData *ud = m_frozen_userdata; ud; ud = ud->m_gc_next)
+            {
+                m_side_marks.set(ud->m_gc_side_idx);
+                ud->mark(this, m_current_color);
+            }
+        }
+
+        void mark()
+        {
+            mark_begin();
+            // New objects get the current color, the next mark flips
+            // it and so they start out unmarked there:
+            m_alloc_color = m_current_color;
+
+            if (   m_mark_threads > 1
+                &&   m_num_alive_vectors  + m_num_alive_maps
+                   + m_num_frozen_vectors + m_num_frozen_maps
+                   >= GC_PARALLEL_MARK_MIN_OBJECTS)
+                mark_stacks_parallel();
+            else
+                mark_stacks();
+        }
+
+        // Drains the mark stacks with the GCParallelMarker. The userdata
+        // it finds is marked here, as its mark() calls back into the GC.
+        // The objects found by that are handed to the marker again.
+        void mark_stacks_parallel()
+        {
+            if (!m_par_marker || m_par_marker->num_threads() != m_mark_threads)
+                m_par_marker.reset(new GCParallelMarker(m_mark_threads));
+
+            std::vector<UserData *> userdata;
+
+            while (!(   m_gc_vec_stack.empty()
+                     && m_gc_map_stack.empty()))
+            {
+                bool ok =
+                    m_par_marker->mark(
+                        m_current_color, m_side_marks.m_bits.data(),
+                        m_gc_vec_stack, m_gc_map_stack, userdata);
+#               if GC_DEBUG_MODE
+                    if (!ok)
+                        throw BukaLISPException("Major GC rooting bug: GC marking free or deleted vector");
+#               else
+                    (void) ok;
+#               endif
+
+                for (auto ud : userdata)
+                    ud->mark(this, m_current_color);
+                userdata.clear();
+            }
+        }
+
+        // Starts a major collection, that marks in steps of at most
+        // m_pause_budget_us (see mark_step()). The program continues
+        // between the steps. Marked objects that are written to are
+        // remembered by gc_write_barrier() and scanned again by remark().
+        void start_incremental_mark()
+        {
+            // New objects are allocated unmarked, they are marked by
+            // remark() if they are reachable at the end of the mark:
+            m_alloc_color = m_current_color;
+            mark_begin();
+            m_inc_marking = true;
+            g_gc_remembered.m_black_color = m_current_color;
+
+            // The rooted userdata is marked right away, so the current
+            // register rows of the VM are remembered (see mark_reg_row()):
+            AtomVec *pool = m_root_pool.get_pool();
+            for (size_t i = 0; i < pool->m_len; i++)
+            {
+                AtomVec *stripe = pool->m_data[i].m_d.vec;
+                for (size_t j = 0; j < stripe->m_len; j++)
+                {
+                    Atom &root = stripe->m_data[j];
+                    if (root.m_type == T_UD && root.m_d.ud)
+                        mark_atom(root);
+                }
+            }
+
+            mark_step();
+        }
+
+        // One step of an incremental mark. The clock is only checked
+        // every GC_MARK_STEP_WORK objects. If the mark stacks run empty
+        // the collection is completed, so the last step might take
+        // longer than the budget.
+        void mark_step()
+        {
+            auto deadline =
+                std::chrono::steady_clock::now()
+                + std::chrono::microseconds(m_pause_budget_us);
+
+            m_num_mark_steps++;
+
+            size_t work = 0;
+            while (!(   m_gc_vec_stack.empty()
+                     && m_gc_map_stack.empty()))
+            {
+                if (!m_gc_vec_stack.empty())
+                {
+                    AtomVec *vec = m_gc_vec_stack.back();
+                    m_gc_vec_stack.pop_back();
+                    mark_vector(vec);
+                }
+                else
+                {
+                    AtomMap *map = m_gc_map_stack.back();
+                    m_gc_map_stack.pop_back();
+                    mark_map(map);
+                }
+
+                if (   (++work % GC_MARK_STEP_WORK) == 0
+                    && std::chrono::steady_clock::now() >= deadline)
+                    return;
+            }
+
+            collect();
+        }
+
+        // Completes an incremental mark. Everything that might have
+        // been changed without write barrier since the start of the
+        // mark is scanned again: The root pool, the userdata and
+        // the marked objects in the remembered set.
+        void remark()
+        {
+            AtomVec *pool = m_root_pool.get_pool();
+            for (size_t i = 0; i < pool->m_len; i++)
+            {
+                AtomVec *stripe = pool->m_data[i].m_d.vec;
+                for (size_t j = 0; j < stripe->m_len; j++)
+                    mark_atom(stripe->m_data[j]);
+            }
+
+            for (auto vec : g_gc_remembered.m_vecs)
+                if (is_marked(vec))
+                    scan_vector(vec);
+
+            for (auto map : g_gc_remembered.m_maps)
+                if (is_marked(map))
+                    scan_map(map);
+
+            mark_frozen_roots();
+
+            for (UserData *ud = m_userdata; ud; ud = ud->m_gc_next)
+                if (ud->m_gc_color == m_current_color)
+                    ud->mark(this, m_current_color);
+
+            for (UserData *ud = m_young_userdata; ud; ud = ud->m_gc_next)
+                if (ud->m_gc_color == m_current_color)
+                    ud->mark(this, m_current_color);
+
+            mark_stacks();
+
+            m_inc_marking                 = false;
+            m_alloc_color                 = m_current_color;
+            g_gc_remembered.m_black_color = GC_COLOR_NONE;
+        }
+
+        void mark_stacks()
+        {
             // We use an explicit stack, to prevent C++ stack overflow
             // when marking.
             while (!(   m_gc_vec_stack.empty()
@@ -865,6 +1380,147 @@ class GC
             }
         }
 
+        void mark_minor()
+        {
+            finish_sweep();
+
+            m_minor = true;
+
+            m_gc_vec_stack.clear();
+            m_gc_map_stack.clear();
+
+            // Objects that are remembered while we mark
+            // (see mark_reg_row()) belong to the next minor collection:
+            note_dirty_frozen();
+            GCRememberedSet remembered;
+            std::swap(remembered.m_vecs, g_gc_remembered.m_vecs);
+            std::swap(remembered.m_maps, g_gc_remembered.m_maps);
+
+            for (auto vec : remembered.m_vecs)
+            {
+                vec->m_gc_gen &= ~GC_GEN_REMEMBERED;
+                scan_vector(vec);
+            }
+
+            for (auto map : remembered.m_maps)
+            {
+                map->m_gc_gen &= ~GC_GEN_REMEMBERED;
+                scan_map(map);
+            }
+
+            // Userdata does not have a write barrier, so all of it is
+            // marked again. Its old members are skipped quickly:
+            UserData *ud = m_userdata;
+            while (ud)
+            {
+                ud->mark(this, m_current_color);
+                ud = ud->m_gc_next;
+            }
+            for (ud = m_frozen_userdata; ud; ud = ud->m_gc_next)
+                ud->mark(this, m_current_color);
+
+            // The root pool is written without write barrier,
+            // so all roots are marked. Rooted userdata (like the
+            // register rows of the VM) is marked even if it is old:
+            AtomVec *pool = m_root_pool.get_pool();
+            pool->m_gc_gen |= GC_GEN_OLD;
+            for (size_t i = 0; i < pool->m_len; i++)
+            {
+                AtomVec *stripe = pool->m_data[i].m_d.vec;
+                stripe->m_gc_gen |= GC_GEN_OLD;
+                for (size_t j = 0; j < stripe->m_len; j++)
+                {
+                    Atom &root = stripe->m_data[j];
+                    if (root.m_type == T_UD && root.m_d.ud)
+                    {
+                        root.m_d.ud->m_gc_gen |= GC_GEN_OLD;
+                        root.m_d.ud->mark(this, m_current_color);
+                    }
+                    else
+                        mark_atom(root);
+                }
+            }
+
+            mark_stacks();
+
+            m_minor = false;
+        }
+
+        // Forgets the freed objects in m_freed_remembered from the
+        // remembered set. The other entries might belong to another
+        // GC of this thread, so they are kept.
+        void forget_freed_remembered()
+        {
+            if (m_freed_remembered.empty())
+                return;
+
+            std::sort(m_freed_remembered.begin(), m_freed_remembered.end());
+
+            auto is_freed = [this](void *p) {
+                return std::binary_search(
+                    m_freed_remembered.begin(), m_freed_remembered.end(), p);
+            };
+
+            auto &vecs = g_gc_remembered.m_vecs;
+            vecs.erase(std::remove_if(vecs.begin(), vecs.end(), is_freed), vecs.end());
+            auto &maps = g_gc_remembered.m_maps;
+            maps.erase(std::remove_if(maps.begin(), maps.end(), is_freed), maps.end());
+
+            m_freed_remembered.clear();
+        }
+
+        void free_map(AtomMap *cur)
+        {
+            cur->m_gc_color = GC_COLOR_FREE;
+            if (cur->m_gc_gen & GC_GEN_REMEMBERED)
+                m_freed_remembered.push_back(cur);
+//            std::cout << "SWPMAP[" << Atom(T_MAP, cur).to_write_str() << "]" << std::endl;
+            delete cur;
+        }
+
+        void free_userdata(UserData *cur)
+        {
+            cur->m_gc_color = GC_COLOR_FREE;
+//            std::cout << "SWEEP USERDATA: " << cur << std::endl;
+            delete cur;
+        }
+
+        void free_vector(AtomVec *cur)
+        {
+            cur->m_gc_color = GC_COLOR_FREE;
+            if (cur->m_gc_gen & GC_GEN_REMEMBERED)
+                m_freed_remembered.push_back(cur);
+            give_back_vector(cur);
+        }
+
+        void sweep_minor()
+        {
+            size_t promoted = 0;
+
+            gc_list_sweep_young<AtomMap>(
+                m_young_maps, m_maps, promoted,
+                [this](AtomMap *cur) { free_map(cur); });
+            m_young_maps             = nullptr;
+            m_num_alive_maps        += promoted;
+            m_num_promoted_maps     += promoted;
+
+            gc_list_sweep_young<UserData>(
+                m_young_userdata, m_userdata, promoted,
+                [this](UserData *cur) { free_userdata(cur); });
+            m_young_userdata         = nullptr;
+            m_num_alive_userdata    += promoted;
+            m_num_promoted_userdata += promoted;
+
+            gc_list_sweep_young<AtomVec>(
+                m_young_vectors, m_vectors, promoted,
+                [this](AtomVec *cur) { free_vector(cur); });
+            m_young_vectors          = nullptr;
+            m_num_alive_vectors     += promoted;
+            m_num_promoted_vectors  += promoted;
+
+            forget_freed_remembered();
+        }
+
         void sweep()
         {
             m_syms =
@@ -882,41 +1538,174 @@ class GC
                         delete cur;
                     });
 
-            m_maps =
-                gc_list_sweep<AtomMap>(
-                    m_maps,
-                    m_num_alive_maps,
+            size_t num_strings = 0;
+            m_strings =
+                gc_list_sweep<Sym>(
+                    m_strings,
+                    num_strings,
                     m_current_color,
-                    [this](AtomMap *cur)
+                    [this](Sym *cur)
                     {
                         cur->m_gc_color = GC_COLOR_FREE;
-//                        std::cout << "SWPMAP[" << Atom(T_MAP, cur).to_write_str() << "]" << std::endl;
+                        m_string_bytes -= cur->m_str.size();
                         delete cur;
                     });
+            m_num_alive_strings = num_strings;
+
+            size_t num_young = 0;
+
+#           if GC_LAZY_SWEEP
+                // The old objects are swept after the pause by
+                // sweep_step(), only the nursery is swept here.
+                // m_num_alive_* still count the unswept objects.
+                m_unswept_maps     = m_maps;
+                m_unswept_userdata = m_userdata;
+                m_unswept_vectors  = m_vectors;
+                m_maps             = nullptr;
+                m_userdata         = nullptr;
+                m_vectors          = nullptr;
+#           else
+                m_maps =
+                    gc_list_sweep<AtomMap>(
+                        m_maps,
+                        m_num_alive_maps,
+                        m_current_color,
+                        [this](AtomMap *cur) { free_map(cur); });
+                m_userdata =
+                    gc_list_sweep<UserData>(
+                        m_userdata,
+                        m_num_alive_userdata,
+                        m_current_color,
+                        [this](UserData *cur) { free_userdata(cur); });
+                m_vectors =
+                    gc_list_sweep<AtomVec>(
+                        m_vectors,
+                        m_num_alive_vectors,
+                        m_current_color,
+                        [this](AtomVec *cur) { free_vector(cur); });
+#           endif
+
+            m_young_maps =
+                gc_list_sweep<AtomMap>(
+                    m_young_maps,
+                    num_young,
+                    m_current_color,
+                    [this](AtomMap *cur) { free_map(cur); });
+            m_maps            = gc_list_promote<AtomMap>(m_young_maps, m_maps);
+            m_young_maps      = nullptr;
+            m_num_alive_maps += num_young;
 
-            m_userdata =
+            m_young_userdata =
                 gc_list_sweep<UserData>(
-                    m_userdata,
-                    m_num_alive_userdata,
+                    m_young_userdata,
+                    num_young,
                     m_current_color,
-                    [this](UserData *cur)
-                    {
-                        cur->m_gc_color = GC_COLOR_FREE;
-//                        std::cout << "SWPMAP[" << Atom(T_MAP, cur).to_write_str() << "]" << std::endl;
-//                        std::cout << "SWEEP USERDATA: " << cur << std::endl;
-                        delete cur;
-                    });
+                    [this](UserData *cur) { free_userdata(cur); });
+            m_userdata            = gc_list_promote<UserData>(m_young_userdata, m_userdata);
+            m_young_userdata      = nullptr;
+            m_num_alive_userdata += num_young;
 
-            m_vectors =
+            m_young_vectors =
                 gc_list_sweep<AtomVec>(
-                    m_vectors,
-                    m_num_alive_vectors,
+                    m_young_vectors,
+                    num_young,
                     m_current_color,
-                    [this](AtomVec *cur)
-                    {
-                        cur->m_gc_color = GC_COLOR_FREE;
-                        give_back_vector(cur);
-                    });
+                    [this](AtomVec *cur) { free_vector(cur); });
+            m_vectors            = gc_list_promote<AtomVec>(m_young_vectors, m_vectors);
+            m_young_vectors      = nullptr;
+            m_num_alive_vectors += num_young;
+
+            forget_freed_remembered();
+
+            if (!sweep_pending())
+                update_heap_target();
+        }
+
+        void update_heap_target()
+        {
+            double live   = (double) heap_bytes();
+            double target = live * m_heap_growth;
+
+            if (target < (double) m_heap_min_bytes)
+                target = (double) m_heap_min_bytes;
+
+            // Near the soft limit the heap still gets a quarter of
+            // headroom, or we would collect on every allocation:
+            if (   m_heap_soft_limit_bytes > 0
+                && target > (double) m_heap_soft_limit_bytes)
+                target =
+                    std::max((double) m_heap_soft_limit_bytes,
+                             live + live / 4);
+
+            m_heap_target_bytes = (size_t) target;
+        }
+
+        bool sweep_pending() const
+        {
+            return m_unswept_maps || m_unswept_userdata || m_unswept_vectors;
+        }
+
+        // Sweeps up to max_work of the old objects, that were
+        // left unswept by the last major collection.
+        void sweep_step(size_t max_work)
+        {
+            size_t freed = 0;
+            size_t work  = 0;
+
+            work +=
+                gc_list_sweep_some<AtomMap>(
+                    m_unswept_maps, m_maps, max_work - work,
+                    m_current_color, freed,
+                    [this](AtomMap *cur) { free_map(cur); });
+            m_num_alive_maps -= freed;
+            freed = 0;
+
+            work +=
+                gc_list_sweep_some<UserData>(
+                    m_unswept_userdata, m_userdata, max_work - work,
+                    m_current_color, freed,
+                    [this](UserData *cur) { free_userdata(cur); });
+            m_num_alive_userdata -= freed;
+            freed = 0;
+
+            work +=
+                gc_list_sweep_some<AtomVec>(
+                    m_unswept_vectors, m_vectors, max_work - work,
+                    m_current_color, freed,
+                    [this](AtomVec *cur) { free_vector(cur); });
+            m_num_alive_vectors -= freed;
+
+            m_num_lazy_swept += work;
+
+            forget_freed_remembered();
+
+            if (!sweep_pending())
+                update_heap_target();
+        }
+
+        // Completes the lazy sweep. The unswept objects still carry
+        // the color of the last mark, which becomes meaningless when
+        // the next mark starts. And the dead ones might still be in
+        // the remembered set, where a minor collection would scan them.
+        void finish_sweep()
+        {
+            if (!sweep_pending())
+                return;
+
+            size_t lazy = m_num_lazy_swept;
+            sweep_step((size_t) -1);
+            m_num_lazy_swept = lazy;
+        }
+
+        Sym *allocate_string()
+        {
+            Sym *new_str        = new Sym;
+            new_str->m_hash     = 0;
+            new_str->m_gc_color = m_current_color;
+            new_str->m_gc_next  = m_strings;
+            m_strings           = new_str;
+            m_num_new_strings++;
+            return new_str;
         }
 
         Sym *allocate_sym()
@@ -933,16 +1722,25 @@ class GC
         {
             if (!vec) return;
 
-            if (vec->m_gc_color == m_current_color)
-                return;
-
 #           if GC_DEBUG_MODE
                 if (vec->m_gc_color == GC_COLOR_FREE)
                     throw BukaLISPException("Major GC rooting bug: GC marking free or deleted vector");
 #           endif
 
-            vec->m_gc_color = m_current_color;
+            if (m_minor)
+            {
+                if (vec->m_gc_gen & GC_GEN_OLD)
+                    return;
+                vec->m_gc_gen |= GC_GEN_OLD;
+            }
+            else if (!set_mark(vec))
+                return;
 
+            scan_vector(vec);
+        }
+
+        void scan_vector(AtomVec *vec)
+        {
             for (size_t i = 0; i < vec->m_len; i++)
             {
                 mark_atom(vec->m_data[i]);
@@ -958,8 +1756,26 @@ class GC
             : m_vectors(nullptr),
               m_maps(nullptr),
               m_syms(nullptr),
+              m_strings(nullptr),
               m_userdata(nullptr),
+              m_young_vectors(nullptr),
+              m_young_maps(nullptr),
+              m_young_userdata(nullptr),
+              m_unswept_vectors(nullptr),
+              m_unswept_maps(nullptr),
+              m_unswept_userdata(nullptr),
+              m_frozen_vectors(nullptr),
+              m_frozen_maps(nullptr),
+              m_frozen_userdata(nullptr),
+              m_frozen_syms(nullptr),
+              m_frozen_strings(nullptr),
+              m_num_side_marks(0),
               m_current_color(GC_COLOR_WHITE),
+              m_alloc_color(GC_COLOR_WHITE),
+              m_minor(false),
+              m_inc_marking(false),
+              m_pause_budget_us(GC_PAUSE_BUDGET_US),
+              m_mark_threads(GC_MARK_THREADS),
               m_tiny_vectors(nullptr),
               m_small_vectors(nullptr),
               m_medium_vectors(nullptr),
@@ -967,6 +1783,9 @@ class GC
               m_num_small_vectors(0),
               m_num_medium_vectors(0),
               m_num_alive_syms(0),
+              m_num_alive_strings(0),
+              m_num_new_strings(0),
+              m_string_bytes(0),
               m_num_alive_userdata(0),
               m_num_alive_maps(0),
               m_num_alive_vectors(0),
@@ -974,6 +1793,22 @@ class GC
               m_num_new_userdata(0),
               m_num_new_vectors(0),
               m_num_new_maps(0),
+              m_num_promoted_vectors(0),
+              m_num_promoted_maps(0),
+              m_num_promoted_userdata(0),
+              m_num_frozen_vectors(0),
+              m_num_frozen_maps(0),
+              m_num_frozen_userdata(0),
+              m_num_frozen_syms(0),
+              m_num_frozen_strings(0),
+              m_num_minor_collections(0),
+              m_num_major_collections(0),
+              m_num_mark_steps(0),
+              m_num_lazy_swept(0),
+              m_heap_growth(GC_HEAP_GROWTH),
+              m_heap_min_bytes(GC_HEAP_MIN_BYTES),
+              m_heap_soft_limit_bytes(GC_HEAP_SOFT_LIMIT_BYTES),
+              m_heap_target_bytes(GC_HEAP_MIN_BYTES),
               m_free_unallocated_atom_vecs(nullptr),
               m_root_pool([=](size_t len) { return this->allocate_vector(len); })
         {
@@ -987,6 +1822,43 @@ class GC
 
         void add_permanent(Sym *sym) { m_perm_syms.push_back(sym); }
 
+        void   set_pause_budget_us(size_t us) { m_pause_budget_us = us; }
+        size_t get_pause_budget_us() const    { return m_pause_budget_us; }
+
+        void   set_mark_threads(size_t n) { m_mark_threads = n; }
+        size_t get_mark_threads() const   { return m_mark_threads; }
+
+        // The heap limits are used from the next major collection on:
+        void   set_heap_growth(double f)            { m_heap_growth = f; }
+        double get_heap_growth() const              { return m_heap_growth; }
+        void   set_heap_min_bytes(size_t b)         { m_heap_min_bytes = b; }
+        size_t get_heap_min_bytes() const           { return m_heap_min_bytes; }
+        void   set_heap_soft_limit_bytes(size_t b)  { m_heap_soft_limit_bytes = b; }
+        size_t get_heap_soft_limit_bytes() const    { return m_heap_soft_limit_bytes; }
+        size_t get_heap_target_bytes() const        { return m_heap_target_bytes; }
+
+        // Estimates the bytes used by the objects of this GC. Atom
+        // arrays are only accounted for if they come from the
+        // g_atom_array_pool, which is shared by the GCs of a thread.
+        size_t heap_bytes() const
+        {
+            size_t bytes =
+                  (m_num_alive_vectors  + m_num_new_vectors)  * sizeof(AtomVec)
+                + (m_num_alive_maps     + m_num_new_maps)     * sizeof(AtomMap)
+                + (m_num_alive_userdata + m_num_new_userdata) * sizeof(UserData)
+                + (m_num_alive_syms     + m_num_new_syms)     * sizeof(Sym)
+                + (m_num_alive_strings  + m_num_new_strings)  * sizeof(Sym)
+                + m_num_frozen_vectors  * sizeof(AtomVec)
+                + m_num_frozen_maps     * sizeof(AtomMap)
+                + m_num_frozen_userdata * sizeof(UserData)
+                + (m_num_frozen_syms + m_num_frozen_strings) * sizeof(Sym)
+                + m_string_bytes;
+#           if WITH_MEM_POOL
+                bytes += g_atom_array_pool.bytes_in_use();
+#           endif
+            return bytes;
+        }
+
         Atom get_statistics();
 
         void give_back_vector(AtomVec *cur)
@@ -1034,8 +1906,9 @@ class GC
 
         void reg_userdata(UserData *ud)
         {
-            ud->m_gc_next = m_userdata;
-            m_userdata = ud;
+            ud->m_gc_gen  = GC_GEN_YOUNG;
+            ud->m_gc_next = m_young_userdata;
+            m_young_userdata = ud;
             ud->mark(this, m_current_color);
             m_num_new_userdata++;
         }
@@ -1061,6 +1934,16 @@ class GC
                                 throw BukaLISPException("Major GC rooting bug: GC marking free or deleted vector");
 #                       endif
 
+                        if (m_minor)
+                        {
+                            // Old userdata was already marked by mark_minor():
+                            if (at.m_d.ud->m_gc_gen & GC_GEN_OLD)
+                                break;
+                            at.m_d.ud->m_gc_gen |= GC_GEN_OLD;
+                        }
+                        else if (at.m_d.ud->m_gc_color == GC_COLOR_FROZEN)
+                            m_side_marks.set(at.m_d.ud->m_gc_side_idx);
+
                         at.m_d.ud->mark(this, m_current_color);
                     }
                     break;
@@ -1069,7 +1952,7 @@ class GC
                 case T_KW:
                 case T_SYM:
                 case T_STR:
-                    if (at.m_d.sym)
+                    if (at.m_d.sym && at.m_d.sym->m_gc_color != GC_COLOR_FROZEN)
                         at.m_d.sym->m_gc_color = m_current_color;
                     break;
             }
@@ -1077,11 +1960,24 @@ class GC
 
         void collect_maybe()
         {
+            // Minor collections wait until the incremental mark is done:
+            if (m_inc_marking)
+            {
+                mark_step();
+                return;
+            }
+
+            if (sweep_pending())
+                sweep_step(GC_SWEEP_STEP_WORK);
+
+            // A major collection is done when the heap grew beyond
+            // m_heap_target_bytes, see update_heap_target(). The debug
+            // mode collects when the old generation grew by a 16th.
 #           if GC_DEBUG_MODE
-                if (   (m_num_new_maps     > (m_num_alive_maps     / 16))
-                    || (m_num_new_vectors  > (m_num_alive_vectors  / 16))
-                    || (m_num_new_syms     > (m_num_alive_syms     / 16))
-                    || (m_num_new_userdata > (m_num_alive_userdata / 16)))
+                if (   (m_num_promoted_maps     > (m_num_alive_maps     / 16))
+                    || (m_num_promoted_vectors  > (m_num_alive_vectors  / 16))
+                    || (m_num_new_syms          > (m_num_alive_syms     / 16))
+                    || (m_num_promoted_userdata > (m_num_alive_userdata / 16)))
                 {
     //                std::cout << "GC collect at " << m_num_new_vectors
     //                          << " <=> " << m_num_alive_vectors << std::endl;
@@ -1089,23 +1985,67 @@ class GC
     //                          << " <=> " << m_num_alive_maps << std::endl;
     //                std::cout << "GC collect at " << m_num_new_syms
     //                          << " <=> " << m_num_alive_syms << std::endl;
-                    collect();
+                    collect_major();
                 }
 #           else
-                if (   (m_num_new_maps     > m_num_alive_maps    )
-                    || (m_num_new_vectors  > m_num_alive_vectors )
-                    || (m_num_new_syms     > m_num_alive_syms    )
-                    || (m_num_new_userdata > m_num_alive_userdata))
+                // The new heap target is only known after the sweep:
+                if (!sweep_pending() && heap_bytes() >= m_heap_target_bytes)
                 {
-    //                std::cout << "GC collect at " << m_num_new_vectors
-    //                          << " <=> " << m_num_alive_vectors << std::endl;
-    //                std::cout << "GC collect at " << m_num_new_maps
-    //                          << " <=> " << m_num_alive_maps << std::endl;
-    //                std::cout << "GC collect at " << m_num_new_syms
-    //                          << " <=> " << m_num_alive_syms << std::endl;
-                    collect();
+    //                std::cout << "GC collect at " << heap_bytes()
+    //                          << " <=> " << m_heap_target_bytes << std::endl;
+                    collect_major();
                 }
 #           endif
+                else if (  m_num_new_maps
+                         + m_num_new_vectors
+                         + m_num_new_userdata > GC_NURSERY_SIZE)
+                {
+                    collect_minor();
+                }
+        }
+
+        void collect_major()
+        {
+            // The parallel marker only does complete collections:
+            if (m_pause_budget_us > 0 && m_mark_threads <= 1)
+                start_incremental_mark();
+            else
+                collect();
+        }
+
+        // Only collects the nursery, the old generation is
+        // only traced from the remembered set and the roots.
+        void collect_minor()
+        {
+            mark_minor();
+            sweep_minor();
+
+            m_num_new_userdata = 0;
+            m_num_new_maps     = 0;
+            m_num_new_vectors  = 0;
+            m_num_minor_collections++;
+        }
+
+        // Marks one of the register rows of the VM. The VM writes to
+        // its current rows without write barrier, so they are always
+        // scanned by a minor collection and stay remembered for the next.
+        void mark_reg_row(AtomVec *row)
+        {
+            if (!row) return;
+
+            if (m_minor)
+            {
+                if (row->m_gc_gen & GC_GEN_OLD)
+                    scan_vector(row);
+                else
+                    mark_vector(row);
+            }
+            else
+                mark_vector(row);
+
+            row->m_gc_gen |= GC_GEN_OLD;
+            if (!(row->m_gc_gen & GC_GEN_REMEMBERED))
+                gc_remember(row);
         }
 
         void collect()
@@ -1115,13 +2055,21 @@ class GC
 //                << ",m:" << count_potentially_alive_maps()
 //                << ",s:" << count_potentially_alive_syms()
 //                << std::endl;
-            mark();
+            if (m_inc_marking)
+                remark();
+            else
+                mark();
             sweep();
 
-            m_num_new_userdata = 0;
-            m_num_new_maps     = 0;
-            m_num_new_syms     = 0;
-            m_num_new_vectors  = 0;
+            m_num_new_userdata      = 0;
+            m_num_new_maps          = 0;
+            m_num_new_syms          = 0;
+            m_num_new_strings       = 0;
+            m_num_new_vectors       = 0;
+            m_num_promoted_userdata = 0;
+            m_num_promoted_maps     = 0;
+            m_num_promoted_vectors  = 0;
+            m_num_major_collections++;
 //            std::cout << "**** gc collect end **** " << AtomVec::s_alloc_count
 //                << ",v:" << count_potentially_alive_vectors()
 //                << ",m:" << count_potentially_alive_maps()
@@ -1129,6 +2077,71 @@ class GC
 //                << std::endl;
         }
 
+        // Makes all objects, that survive a full collection, permanent.
+        // They are moved to the m_frozen_* lists, which are never swept,
+        // and their mark bits are kept in m_side_marks. Collections in a
+        // process forked after this only read the frozen objects, so
+        // their pages stay shared with the parent process (unless the
+        // program writes to the objects). See run_fork_server().
+        void freeze()
+        {
+            if (m_inc_marking)
+                collect();
+            collect();
+            finish_sweep();
+
+            // The threads of the parallel marker do not survive a fork(),
+            // a new marker is created by the next parallel mark:
+            m_par_marker.reset();
+
+            // The collection promoted all survivors to the old lists:
+            uint32_t idx = m_num_side_marks;
+            m_frozen_vectors =
+                gc_list_freeze<AtomVec>(
+                    m_vectors, m_frozen_vectors,
+                    [&idx](AtomVec *cur) { cur->m_gc_side_idx = idx++; });
+            m_frozen_maps =
+                gc_list_freeze<AtomMap>(
+                    m_maps, m_frozen_maps,
+                    [&idx](AtomMap *cur) { cur->m_gc_side_idx = idx++; });
+            m_frozen_userdata =
+                gc_list_freeze<UserData>(
+                    m_userdata, m_frozen_userdata,
+                    [&idx](UserData *cur) { cur->m_gc_side_idx = idx++; });
+            m_frozen_syms =
+                gc_list_freeze<Sym>(m_syms, m_frozen_syms, [](Sym *) { });
+            m_frozen_strings =
+                gc_list_freeze<Sym>(m_strings, m_frozen_strings, [](Sym *) { });
+
+            m_vectors  = nullptr;
+            m_maps     = nullptr;
+            m_userdata = nullptr;
+            m_syms     = nullptr;
+            m_strings  = nullptr;
+
+            m_num_frozen_vectors  += m_num_alive_vectors;
+            m_num_frozen_maps     += m_num_alive_maps;
+            m_num_frozen_userdata += m_num_alive_userdata;
+            m_num_frozen_syms     += m_num_alive_syms;
+            m_num_frozen_strings  += m_num_alive_strings;
+            m_num_alive_vectors  = 0;
+            m_num_alive_maps     = 0;
+            m_num_alive_userdata = 0;
+            m_num_alive_syms     = 0;
+            m_num_alive_strings  = 0;
+
+            m_num_side_marks = idx;
+            m_side_marks.resize(m_num_side_marks);
+            m_frozen_dirty.resize(m_num_side_marks);
+        }
+
+        size_t num_frozen_objects() const
+        {
+            return   m_num_frozen_vectors + m_num_frozen_maps
+                   + m_num_frozen_userdata + m_num_frozen_syms
+                   + m_num_frozen_strings;
+        }
+
         Sym *new_symbol(const std::string &str)
         {
             auto it = m_symtbl.find(str);
@@ -1136,7 +2149,8 @@ class GC
             {
                 Sym *newsym = allocate_sym();
 //                std::cout << "NEW SYM: " << str << std::endl;
-                newsym->m_str = str;
+                newsym->m_str  = str;
+                newsym->m_hash = std::hash<std::string>()(str);
                 m_symtbl.insert(std::pair<std::string, Sym *>(str, newsym));
                 return newsym;
             }
@@ -1144,13 +2158,32 @@ class GC
                 return it->second;
         }
 
+        // Strings (T_STR) are not interned, so they can be created and
+        // freed without hashing them. They are compared by content.
+        Sym *new_string(const std::string &str)
+        {
+            Sym *newstr = allocate_string();
+            newstr->m_str = str;
+            m_string_bytes += str.size();
+            return newstr;
+        }
+
+        Sym *new_string(std::string &&str)
+        {
+            Sym *newstr = allocate_string();
+            newstr->m_str = std::move(str);
+            m_string_bytes += newstr->m_str.size();
+            return newstr;
+        }
+
         AtomMap *allocate_map()
         {
             AtomMap *new_map = new AtomMap;
 
-            new_map->m_gc_color = m_current_color;
-            new_map->m_gc_next  = m_maps;
-            m_maps              = new_map;
+            new_map->m_gc_color = m_alloc_color;
+            new_map->m_gc_gen   = GC_GEN_YOUNG;
+            new_map->m_gc_next  = m_young_maps;
+            m_young_maps        = new_map;
             m_num_new_maps++;
 
             return new_map;
@@ -1209,10 +2242,11 @@ class GC
 //                m_tiny_vectors = m_tiny_vectors->m_gc_next;
 //            }
 
-            new_vec->init(m_current_color, 0);
+            new_vec->init(m_alloc_color, 0);
 
-            new_vec->m_gc_next = m_vectors;
-            m_vectors          = new_vec;
+            new_vec->m_gc_gen  = GC_GEN_YOUNG;
+            new_vec->m_gc_next = m_young_vectors;
+            m_young_vectors    = new_vec;
             m_num_new_vectors++;
 
             return new_vec;
@@ -1224,13 +2258,19 @@ class GC
                 || a.m_type == T_CLOS)
             {
                 if (!a.m_d.vec->m_meta)
+                {
                     a.m_d.vec->m_meta = this->allocate_vector(i + 1);
+                    gc_write_barrier(a.m_d.vec);
+                }
                 a.m_d.vec->m_meta->set(i, meta);
             }
             else if (a.m_type == T_MAP)
             {
                 if (!a.m_d.map->m_meta)
+                {
                     a.m_d.map->m_meta = this->allocate_vector(i + 1);
+                    gc_write_barrier(a.m_d.map);
+                }
                 a.m_d.map->m_meta->set(i, meta);
             }
         }
@@ -1261,6 +2301,12 @@ class GC
             size_t i = 0;
             AtomVec *v = m_vectors;
             while (v) { i++; v = v->m_gc_next; }
+            v = m_unswept_vectors;
+            while (v) { i++; v = v->m_gc_next; }
+            v = m_young_vectors;
+            while (v) { i++; v = v->m_gc_next; }
+            v = m_frozen_vectors;
+            while (v) { i++; v = v->m_gc_next; }
             return i;
         }
 
@@ -1269,6 +2315,12 @@ class GC
             size_t i = 0;
             AtomMap *v = m_maps;
             while (v) { i++; v = v->m_gc_next; }
+            v = m_unswept_maps;
+            while (v) { i++; v = v->m_gc_next; }
+            v = m_young_maps;
+            while (v) { i++; v = v->m_gc_next; }
+            v = m_frozen_maps;
+            while (v) { i++; v = v->m_gc_next; }
             return i;
         }
 
@@ -1281,6 +2333,32 @@ class GC
         {
             size_t dummy;
 
+            finish_sweep();
+
+            // Our objects must not stay in the remembered set of this thread:
+            for (AtomVec *v = m_vectors; v; v = v->m_gc_next)
+                if (v->m_gc_gen & GC_GEN_REMEMBERED)
+                    m_freed_remembered.push_back(v);
+            for (AtomVec *v = m_young_vectors; v; v = v->m_gc_next)
+                if (v->m_gc_gen & GC_GEN_REMEMBERED)
+                    m_freed_remembered.push_back(v);
+            for (AtomMap *m = m_maps; m; m = m->m_gc_next)
+                if (m->m_gc_gen & GC_GEN_REMEMBERED)
+                    m_freed_remembered.push_back(m);
+            for (AtomMap *m = m_young_maps; m; m = m->m_gc_next)
+                if (m->m_gc_gen & GC_GEN_REMEMBERED)
+                    m_freed_remembered.push_back(m);
+            for (AtomVec *v = m_frozen_vectors; v; v = v->m_gc_next)
+                if (v->m_gc_gen & GC_GEN_REMEMBERED)
+                    m_freed_remembered.push_back(v);
+            for (AtomMap *m = m_frozen_maps; m; m = m->m_gc_next)
+                if (m->m_gc_gen & GC_GEN_REMEMBERED)
+                    m_freed_remembered.push_back(m);
+            forget_freed_remembered();
+
+            if (m_inc_marking)
+                g_gc_remembered.m_black_color = GC_COLOR_NONE;
+
             gc_list_sweep<Sym>(
                 m_syms,
                 dummy,
@@ -1289,6 +2367,12 @@ class GC
 //                    std::cout << "DELSYM[" << cur->m_str << "]" << std::endl;
                     delete cur; });
 
+            gc_list_sweep<Sym>(
+                m_strings,
+                dummy,
+                GC_COLOR_DELETE,
+                [](Sym *cur) { delete cur; });
+
             gc_list_sweep<AtomVec>(
                 m_medium_vectors,
                 dummy,
@@ -1313,12 +2397,24 @@ class GC
                 GC_COLOR_DELETE,
                 [this](AtomVec *cur) { delete cur; });
 
+            gc_list_sweep<AtomVec>(
+                m_young_vectors,
+                dummy,
+                GC_COLOR_DELETE,
+                [this](AtomVec *cur) { delete cur; });
+
             gc_list_sweep<AtomMap>(
                 m_maps,
                 dummy,
                 GC_COLOR_DELETE,
                 [this](AtomMap *cur) { delete cur; });
 
+            gc_list_sweep<AtomMap>(
+                m_young_maps,
+                dummy,
+                GC_COLOR_DELETE,
+                [this](AtomMap *cur) { delete cur; });
+
             gc_list_sweep<UserData>(
                 m_userdata,
                 dummy,
@@ -1328,6 +2424,28 @@ class GC
 //                    std::cout << "SWEEP USERDATA: " << cur << std::endl;
                     delete cur;
                 });
+
+            gc_list_sweep<UserData>(
+                m_young_userdata,
+                dummy,
+                GC_COLOR_DELETE,
+                [this](UserData *cur) { delete cur; });
+
+            gc_list_sweep<AtomVec>(
+                m_frozen_vectors, dummy, GC_COLOR_DELETE,
+                [this](AtomVec *cur) { delete cur; });
+            gc_list_sweep<AtomMap>(
+                m_frozen_maps, dummy, GC_COLOR_DELETE,
+                [this](AtomMap *cur) { delete cur; });
+            gc_list_sweep<UserData>(
+                m_frozen_userdata, dummy, GC_COLOR_DELETE,
+                [this](UserData *cur) { delete cur; });
+            gc_list_sweep<Sym>(
+                m_frozen_syms, dummy, GC_COLOR_DELETE,
+                [](Sym *cur) { delete cur; });
+            gc_list_sweep<Sym>(
+                m_frozen_strings, dummy, GC_COLOR_DELETE,
+                [](Sym *cur) { delete cur; });
         }
 };
 //---------------------------------------------------------------------------
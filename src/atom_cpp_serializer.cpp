@@ -42,7 +42,8 @@ class Atom2CPP
             ostream &o)
         {
             o << "Atom " << name << "(" << type << ");";
-            o << name << ".m_d.sym = gc.new_symbol(";
+            o << name << ".m_d.sym = gc."
+              << (type == "T_STR" ? "new_string(" : "new_symbol(");
             o << "\"";
             for (auto i : value)
             {
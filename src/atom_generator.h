@@ -96,6 +96,8 @@ class AtomGenerator : public bukalisp::SEX_Builder
             if (m_include_debug_info)
             {
                 AtomVec *meta_info = m_gc->allocate_vector(2);
+                // The file name is repeated for every list and map,
+                // so it is interned:
                 meta_info->push(Atom(T_STR, m_gc->new_symbol(m_dbg_input_name)));
                 meta_info->push(Atom(T_INT, m_dbg_line));
                 m_gc->set_meta_register(new_vec_atom, 0, Atom(T_VEC, meta_info));
@@ -121,6 +123,8 @@ class AtomGenerator : public bukalisp::SEX_Builder
             if (m_include_debug_info)
             {
                 AtomVec *meta_info = m_gc->allocate_vector(2);
+                // The file name is repeated for every list and map,
+                // so it is interned:
                 meta_info->push(Atom(T_STR, m_gc->new_symbol(m_dbg_input_name)));
                 meta_info->push(Atom(T_INT, m_dbg_line));
                 m_gc->set_meta_register(new_map_atom, 0, Atom(T_VEC, meta_info));
@@ -175,7 +179,7 @@ class AtomGenerator : public bukalisp::SEX_Builder
         virtual void atom_string(const std::string &str)
         {
             Atom a(T_STR);
-            a.m_d.sym = m_gc->new_symbol(str);
+            a.m_d.sym = m_gc->new_string(str);
             ON_NXT_LBL_SET_REFMAP(a);
             add(a);
         }
@@ -28,6 +28,13 @@ class AtomHash
 typedef std::unordered_map<Atom, Atom, AtomHash>    UnordAtomMap;
 //---------------------------------------------------------------------------
 
+template<typename Atom, typename HashFunc>
+struct HashTable;
+
+// Remembers the map for the GC if necessary, defined in atom.h.
+inline void gc_write_barrier(HashTable<Atom, AtomHash> *map);
+//---------------------------------------------------------------------------
+
 #define ATOM_HASH_TABLE_SIZE_COUNT 29
 extern const size_t HASH_TABLE_SIZES[ATOM_HASH_TABLE_SIZE_COUNT];
 
@@ -39,6 +46,8 @@ template<typename Atom, typename HashFunc>
 struct HashTable
 {
     uint8_t         m_gc_color;
+    uint8_t         m_gc_gen;
+    uint32_t        m_gc_side_idx;
     HashTable<Atom, HashFunc>
                    *m_gc_next;
     UnordAtomMap    m_map;
@@ -46,7 +55,7 @@ struct HashTable
 
     //---------------------------------------------------------------------------
 
-    HashTable() : m_gc_next(nullptr), m_gc_color(0), m_meta(nullptr) { }
+    HashTable() : m_gc_next(nullptr), m_gc_color(GC_COLOR_UNMANAGED), m_gc_gen(0), m_gc_side_idx(0), m_meta(nullptr) { }
 
     void clear()
     {
@@ -64,12 +73,14 @@ struct HashTable
     {
         Atom sym(T_SYM, s);
         m_map[sym] = a;
+        gc_write_barrier(this);
     }
     //---------------------------------------------------------------------------
 
     void set(const Atom &k, const Atom &a)
     {
         m_map[k] = a;
+        gc_write_barrier(this);
     }
     //---------------------------------------------------------------------------
 
@@ -97,8 +108,13 @@ struct HashTable
 
 #else // NOT WITH_STD_UNORDERED_MAP
 
-#define HT_INIT_SIZE    23
-#define HT_NEXT_TBL_IDX 3
+// Maps with up to HT_SMALL_MAX entries are stored as a plain array
+// of [key, value] pairs that is searched linearly, without hashing.
+// The capacities 1 and 5 fill the tiny (2) and small (10) blocks
+// of g_atom_array_pool exactly. Bigger maps switch to the open
+// addressing table of [HPAIR(hash, idx), key, value] triples.
+#define HT_SMALL_MAX        8
+#define HT_FIRST_TBL_IDX    2
 template<typename Atom, typename HashFunc>
 struct HashTable
 {
@@ -109,59 +125,64 @@ struct HashTable
     size_t          m_item_count;
     size_t          m_next_size_tbl_idx;
 
-    Atom            m_initial_buffer[3 * HT_INIT_SIZE];
-
     //---------------------------------------------------------------------------
 
     Atom           *m_begin;
     Atom           *m_end;
 
+    bool            m_small;
     bool            m_inhibit_grow;
 
     uint8_t         m_gc_color;
+    uint8_t         m_gc_gen;
+    uint32_t        m_gc_side_idx;
     HashTable<Atom, HashFunc>
                    *m_gc_next;
     AtomVec        *m_meta;
 
     //---------------------------------------------------------------------------
 
+    // The debug table skips the small representation, so that
+    // "bklisp tests" can exercise the hashed one with tiny sizes.
     HashTable(bool is_debug)
-        : m_table_size(0),
+        : m_gc_color(GC_COLOR_UNMANAGED),
+          m_gc_gen(0),
+          m_gc_side_idx(0),
+          m_table_size(0),
           m_next_size_tbl_idx(0),
           m_item_count(0),
           m_begin(nullptr),
           m_end(nullptr),
+          m_small(false),
           m_inhibit_grow(false),
           m_meta(nullptr)
     {
     }
 
     HashTable()
-        : m_table_size(HT_INIT_SIZE),
-          m_next_size_tbl_idx(HT_NEXT_TBL_IDX),
+        : m_gc_color(GC_COLOR_UNMANAGED),
+          m_gc_gen(0),
+          m_gc_side_idx(0),
+          m_table_size(0),
+          m_next_size_tbl_idx(HT_FIRST_TBL_IDX),
           m_item_count(0),
+          m_begin(nullptr),
+          m_end(nullptr),
+          m_small(true),
           m_inhibit_grow(false),
           m_meta(nullptr)
     {
-        m_begin = &m_initial_buffer[0];
-        m_end   = m_begin + (m_table_size * 3);
     }
 
     void clear()
     {
         free_tbl(m_begin);
-        m_table_size        = HT_INIT_SIZE;
-        m_next_size_tbl_idx = HT_NEXT_TBL_IDX;
+        m_table_size        = 0;
+        m_next_size_tbl_idx = HT_FIRST_TBL_IDX;
         m_item_count        = 0;
-        m_begin             = &m_initial_buffer[0];
-        m_end               = m_begin + (m_table_size * 3);
-
-        Atom *cur = m_begin;
-        while (cur != m_end)
-        {
-            cur->clear();
-            cur += 3;
-        }
+        m_begin             = nullptr;
+        m_end               = nullptr;
+        m_small             = true;
     }
 
     ~HashTable() { free_tbl(m_begin); }
@@ -170,7 +191,7 @@ struct HashTable
 
     void free_tbl(Atom *tbl)
     {
-        if (tbl && tbl != &(m_initial_buffer[0]))
+        if (tbl)
         {
 #          if WITH_MEM_POOL
                g_atom_array_pool.free(tbl);
@@ -181,20 +202,30 @@ struct HashTable
     }
     //---------------------------------------------------------------------------
 
-    Atom *alloc_new_tbl(size_t val_count)
+    Atom *alloc_atoms(size_t atom_count)
     {
         Atom *data;
 #       if WITH_MEM_POOL
-           data = g_atom_array_pool.allocate(val_count * 3);
+           data = g_atom_array_pool.allocate(atom_count);
 #       else
-           data = new Atom[val_count * 3];
+           data = new Atom[atom_count];
 #       endif
         return data;
     }
     //---------------------------------------------------------------------------
 
+    Atom *alloc_new_tbl(size_t val_count) { return alloc_atoms(val_count * 3); }
+
+    static uint32_t fold_hash(size_t h)
+    {
+        return (uint32_t) (((uint64_t) h) ^ (((uint64_t) h) >> 32));
+    }
+
+    //---------------------------------------------------------------------------
+
+    // The hash is folded to the 32 bits that fit into m_d.hpair.key:
     #define AT_HT_CALC_IDX_HASH(key, hash, idx)         \
-            size_t hash = m_hash_func(key);             \
+            size_t hash = fold_hash(m_hash_func(key));  \
             size_t idx  = hash % m_table_size;
 
     #define AT_HT_ITER_START(cur, search_begin, idx)    \
@@ -216,6 +247,7 @@ struct HashTable
         Atom *pair = find_pair(str);
         if (pair) pair[1] = a;
         else      insert(str, a);
+        gc_write_barrier(this);
     }
     //---------------------------------------------------------------------------
 
@@ -248,9 +280,23 @@ struct HashTable
 
     //---------------------------------------------------------------------------
 
+    Atom *find_small_pair(const Atom &key)
+    {
+        Atom *cur = m_begin;
+        Atom *end = m_begin + 2 * m_item_count;
+        for (; cur != end; cur += 2)
+        {
+            if (cur[0] == key)
+                return cur;
+        }
+        return nullptr;
+    }
+    //---------------------------------------------------------------------------
+
     Atom *find_pair(const Atom &key)
     {
         if (!m_begin) return nullptr;
+        if (m_small)  return find_small_pair(key);
 
 //        std::cout << "FIND PARI " << debug_dump();
 //        std::cout << "@" << key.to_write_str() << std::endl;
@@ -269,12 +315,9 @@ struct HashTable
                && cur[0].m_type != T_NIL)
         {
             if (   cur[0].m_type == T_HPAIR
-                && cur[0].m_d.hpair.key == hash)
-            {
-                if (cur[1] == key)
-                    return cur + 1;
-                continue;
-            }
+                && cur[0].m_d.hpair.key == hash
+                && cur[1] == key)
+                return cur + 1;
 
             AT_HT_ITER_NEXT(cur);
         }
@@ -285,6 +328,15 @@ struct HashTable
 
     Atom *next(Atom *cur)
     {
+        if (m_small)
+        {
+            cur = cur ? cur + 2 : m_begin;
+            return
+                cur < m_begin + 2 * m_item_count
+                ? cur
+                : nullptr;
+        }
+
         if (cur == nullptr)
             cur = m_begin + 1;
         else
@@ -302,6 +354,46 @@ struct HashTable
     }
     //---------------------------------------------------------------------------
 
+    void grow_small()
+    {
+        size_t new_size =
+              m_table_size == 0 ? 1
+            : m_table_size <  5 ? 5
+            :                     HT_SMALL_MAX;
+
+        Atom *old_begin = m_begin;
+        m_begin         = alloc_atoms(new_size * 2);
+        m_end           = m_begin + (new_size * 2);
+        m_table_size    = new_size;
+
+        for (size_t i = 0; i < 2 * m_item_count; i++)
+            m_begin[i] = old_begin[i];
+
+        free_tbl(old_begin);
+    }
+    //---------------------------------------------------------------------------
+
+    void small_to_table()
+    {
+        Atom   *old_begin = m_begin;
+        size_t  old_count = m_item_count;
+
+        m_small      = false;
+        m_begin      = nullptr;
+        m_end        = nullptr;
+        m_table_size = 0;
+        grow();
+
+        for (Atom *cur = old_begin; cur != old_begin + 2 * old_count; cur += 2)
+        {
+            AT_HT_CALC_IDX_HASH(cur[0], hash, idx);
+            insert_at(hash, idx, cur[0], cur[1]);
+        }
+
+        free_tbl(old_begin);
+    }
+    //---------------------------------------------------------------------------
+
     void grow()
     {
         if (m_begin && m_inhibit_grow) return;
@@ -376,8 +468,8 @@ struct HashTable
             m_item_count++;
 
         cur[0].m_type        = T_HPAIR;
-        cur[0].m_d.hpair.key = hash;
-        cur[0].m_d.hpair.idx = idx;
+        cur[0].m_d.hpair.key = (uint32_t) hash;
+        cur[0].m_d.hpair.idx = (uint32_t) idx;
         cur[1]               = key;
         cur[2]               = data;
     }
@@ -385,6 +477,25 @@ struct HashTable
 
     void insert(const Atom &key, const Atom &data)
     {
+        if (m_small)
+        {
+            if (m_item_count < m_table_size)
+            {
+                m_begin[2 * m_item_count]     = key;
+                m_begin[2 * m_item_count + 1] = data;
+                m_item_count++;
+                return;
+            }
+            else if (m_table_size < HT_SMALL_MAX)
+            {
+                grow_small();
+                insert(key, data);
+                return;
+            }
+
+            small_to_table();
+        }
+
         if (   m_table_size == 0
             || m_item_count >= ((m_table_size * 3) / 4))
             grow();
@@ -399,6 +510,19 @@ struct HashTable
     {
         Atom *cur = find_pair(key);
         if (!cur) return;
+
+        if (m_small)
+        {
+            // Move the last pair into the hole:
+            Atom *last = m_begin + 2 * (m_item_count - 1);
+            cur[0] = last[0];
+            cur[1] = last[1];
+            last[0].clear();
+            last[1].clear();
+            m_item_count--;
+            return;
+        }
+
         cur--;
         cur[0].set_int(42);
         cur[1].clear();
@@ -410,6 +534,21 @@ struct HashTable
     {
         std::stringstream ss;
 
+        if (m_small)
+        {
+            ss << "#<AtomHashTable small size=" << m_table_size
+               << ", items=" << m_item_count << " [" << std::endl;
+            for (size_t i = 0; i < m_item_count; i++)
+            {
+                ss << " {" << i << "} "
+                   << m_begin[2 * i].to_write_str()
+                   << " => "
+                   << m_begin[2 * i + 1].to_write_str() << std::endl;
+            }
+            ss << "]>" << std::endl;
+            return ss.str();
+        }
+
         ss << "#<AtomHashTable size=" << m_table_size
            << ", items=" << m_item_count << " [" << std::endl;
 
@@ -8,6 +8,14 @@ namespace bukalisp
 {
 //---------------------------------------------------------------------------
 
+void UserData::mark(GC *gc, uint8_t clr)
+{
+    // Frozen userdata is marked in the side bitmap of the GC:
+    if (m_gc_color != GC_COLOR_FROZEN)
+        m_gc_color = clr;
+}
+//---------------------------------------------------------------------------
+
 Atom expand_userdata_to_atoms(GC *gc, Atom in, AtomMap *refmap)
 {
     if (refmap->at(in).m_type != T_NIL)
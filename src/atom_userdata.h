@@ -5,6 +5,7 @@
 
 #include <iostream>
 #include <string>
+#include <stdint.h>
 
 namespace bukalisp
 {
@@ -18,10 +19,12 @@ class UserData
 {
     public:
         uint8_t   m_gc_color;
+        uint8_t   m_gc_gen;
+        uint32_t  m_gc_side_idx;
         UserData *m_gc_next;
 
         UserData()
-            : m_gc_color(), m_gc_next(nullptr)
+            : m_gc_color(), m_gc_gen(), m_gc_side_idx(0), m_gc_next(nullptr)
         {
 //            std::cout << "NEW USERDATA" << this << std::endl;
         }
@@ -34,10 +37,7 @@ class UserData
         {
             return std::string("#<userdata:unknown>");
         }
-        virtual void mark(GC *gc, uint8_t clr)
-        {
-            m_gc_color = clr;
-        }
+        virtual void mark(GC *gc, uint8_t clr);
 
         virtual ~UserData()
         {
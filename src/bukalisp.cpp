@@ -3,37 +3,28 @@
 
 #include "bukalisp.h"
 #include "util.h"
+#include "prog_image.h"
 
 namespace bukalisp
 {
 //---------------------------------------------------------------------------
 
-void Instance::load_bootstrapped_compiler_from_disk()
+void Instance::init_compiler_key(const std::string &compiler_filepath)
 {
-    m_i.cleanup_you_are_unused_now();
-
-    std::string bootstrapped_compiler_filepath =
-        m_rt.find_in_libdirs("compiler.bklc");
-
-    BenchmarkTimer timer_comp_comp;
-
-    Atom compiler_serialized_from_disk =
-        m_rt.read(bootstrapped_compiler_filepath,
-                  slurp_str(bootstrapped_compiler_filepath));
-    compiler_serialized_from_disk =
-        compiler_serialized_from_disk.at(0);
-
-    AtomMap refmap;
-    m_compiler =
-        PROG::repack_expanded_userdata(
-            m_rt.m_gc, compiler_serialized_from_disk, &refmap);
+    std::string compiler_image = slurp_str(compiler_filepath);
 
-    m_compiler = m_vm.eval(m_compiler, nullptr);
+    std::string prim_layout;
+    AtomVec *prim_syms = m_vm.get_primitive_symbol_table();
+    for (size_t i = 0; i < prim_syms->m_len; i++)
+        prim_layout += prim_syms->m_data[i].m_d.sym->m_str + " ";
 
-    std::cout
-        << "Compiler initializing from compiler.bklc done, took: "
-        << timer_comp_comp.diff() << "ms" << std::endl;
+    m_compile_cache.set_compiler_key(compiler_image, prim_layout);
+    m_compiler_key = hash_to_hex(compiler_image) + hash_to_hex(prim_layout);
+}
+//---------------------------------------------------------------------------
 
+void Instance::init_compile_func()
+{
     m_compile_func =
         [this](Atom prog,
             AtomMap *root_env,
@@ -42,7 +33,7 @@ void Instance::load_bootstrapped_compiler_from_disk()
         {
             GC_ROOT_VEC(m_rt.m_gc, args) = m_rt.m_gc.allocate_vector(4);
             args->m_len = 4;
-            args->m_data[0] = Atom(T_STR, m_rt.m_gc.new_symbol(input_name));
+            args->m_data[0] = Atom(T_STR, m_rt.m_gc.new_string(input_name));
             args->m_data[1] = prog;
             args->m_data[2].set_map(root_env);
             args->m_data[3].set_bool(only_compile);
@@ -53,6 +44,106 @@ void Instance::load_bootstrapped_compiler_from_disk()
 }
 //---------------------------------------------------------------------------
 
+void Instance::load_bootstrapped_compiler_from_disk()
+{
+    m_i.cleanup_you_are_unused_now();
+
+    std::string bootstrapped_compiler_filepath =
+        m_rt.find_in_libdirs("compiler.bklc");
+
+    BenchmarkTimer timer_comp_comp;
+
+    init_compiler_key(bootstrapped_compiler_filepath);
+
+    if (is_prog_image_file(bootstrapped_compiler_filepath))
+    {
+        m_compiler =
+            load_prog_image_file(m_rt.m_gc, bootstrapped_compiler_filepath);
+    }
+    else
+    {
+        Atom compiler_serialized_from_disk =
+            m_rt.read(bootstrapped_compiler_filepath,
+                      slurp_str(bootstrapped_compiler_filepath));
+        compiler_serialized_from_disk =
+            compiler_serialized_from_disk.at(0);
+
+        AtomMap refmap;
+        m_compiler =
+            PROG::repack_expanded_userdata(
+                m_rt.m_gc, compiler_serialized_from_disk, &refmap);
+    }
+
+    m_compiler = m_vm.eval(m_compiler, nullptr);
+
+    std::cout
+        << "Compiler initializing from compiler.bklc done, took: "
+        << timer_comp_comp.diff() << "ms" << std::endl;
+
+    init_compile_func();
+}
+//---------------------------------------------------------------------------
+
+bool Instance::load_heap_snapshot(const std::string &filepath)
+{
+    std::string bootstrapped_compiler_filepath =
+        m_rt.find_in_libdirs("compiler.bklc");
+    if (   bootstrapped_compiler_filepath.empty()
+        || !is_prog_image_file(filepath))
+        return false;
+
+    BenchmarkTimer timer_snapshot;
+
+    init_compiler_key(bootstrapped_compiler_filepath);
+
+    GC_ROOT(m_rt.m_gc, snapshot);
+    try
+    {
+        snapshot = load_prog_image_file(m_rt.m_gc, filepath);
+    }
+    catch (BukaLISPException &)
+    {
+        // Written by another build, the caller writes a new one:
+        return false;
+    }
+
+    if (   snapshot.m_type != T_VEC
+        || snapshot.m_d.vec->m_len != 3
+        || snapshot.at(0).to_display_str() != "BKL-HEAP-SNAPSHOT"
+        || snapshot.at(1).to_display_str() != m_compiler_key
+        || snapshot.at(2).m_type != T_CLOS)
+        return false;
+
+    m_i.cleanup_you_are_unused_now();
+
+    m_compiler = snapshot.at(2);
+
+    std::cout
+        << "Compiler initializing from heap snapshot done, took: "
+        << timer_snapshot.diff() << "ms" << std::endl;
+
+    init_compile_func();
+    return true;
+}
+//---------------------------------------------------------------------------
+
+bool Instance::save_heap_snapshot(const std::string &filepath)
+{
+    if (!m_compile_func)
+        throw BukaLISPException(
+            "Can't use Instance::save_heap_snapshot without calling "
+            "load_bootstrapped_compiler_from_disk() first!");
+
+    GC_ROOT_VEC(m_rt.m_gc, snapshot) = m_rt.m_gc.allocate_vector(3);
+    snapshot->push(Atom(T_STR, m_rt.m_gc.new_string("BKL-HEAP-SNAPSHOT")));
+    snapshot->push(Atom(T_STR, m_rt.m_gc.new_string(m_compiler_key)));
+    snapshot->push(m_compiler);
+
+    return save_prog_image_file(
+        m_rt.m_gc, filepath, Atom(T_VEC, snapshot), BKL_PROG_IMAGE_SNAPSHOT);
+}
+//---------------------------------------------------------------------------
+
 Atom Instance::execute_string(const std::string &line, AtomMap *root_env)
 {
     if (!m_compile_func)
@@ -74,20 +165,56 @@ Atom Instance::execute_string(const std::string &line, AtomMap *root_env)
 }
 //---------------------------------------------------------------------------
 
-Atom Instance::execute_file(const std::string &filepath)
+Atom Instance::execute_file(const std::string &filepath, AtomMap *root_env)
 {
     if (!m_compile_func)
         throw BukaLISPException(
             "Can't use Instance::execute_file without calling "
             "load_bootstrapped_compiler_from_disk() first!");
 
-    GC_ROOT(m_rt.m_gc, root_env) = Atom(T_MAP, m_rt.m_gc.allocate_map());
+    // Precompiled .bklc images are run without invoking the compiler:
+    if (is_prog_image_file(filepath))
+    {
+        GC_ROOT(m_rt.m_gc, image_prog) =
+            load_prog_image_file(m_rt.m_gc, filepath);
+
+        m_vm.set_trace(m_trace_vm);
+        Atom ret = m_vm.eval(image_prog, nullptr);
+        m_vm.set_trace(false);
+        return ret;
+    }
+
+    bool use_cache = !root_env;
+    GC_ROOT_MAP(m_rt.m_gc, file_root_env) =
+        root_env ? root_env : m_rt.m_gc.allocate_map();
 
     std::string code_str = slurp_str(filepath);
-    Atom code            = m_rt.read(filepath, code_str);
 
-    Atom vm_prog =
-        m_compile_func(code, root_env.m_d.map, filepath, true);
+    GC_ROOT(m_rt.m_gc, vm_prog) = Atom();
+    if (use_cache)
+        vm_prog = m_compile_cache.load(m_rt.m_gc, filepath, code_str);
+
+    if (vm_prog.m_type == T_NIL)
+    {
+        Atom code = m_rt.read(filepath, code_str);
+
+        m_rt.m_file_read_log.clear();
+        m_rt.m_log_file_reads = use_cache && m_compile_cache.enabled();
+        try
+        {
+            vm_prog = m_compile_func(code, file_root_env, filepath, true);
+        }
+        catch (...)
+        {
+            m_rt.m_log_file_reads = false;
+            throw;
+        }
+        m_rt.m_log_file_reads = false;
+
+        if (use_cache)
+            m_compile_cache.store(
+                m_rt.m_gc, filepath, code_str, m_rt.m_file_read_log, vm_prog);
+    }
 
     m_vm.set_trace(m_trace_vm);
     Atom ret = m_vm.eval(vm_prog, nullptr);
@@ -6,6 +6,7 @@
 #include "buklivm.h"
 #include "interpreter.h"
 #include "atom_generator.h"
+#include "compile_cache.h"
 #include <memory>
 
 namespace bukalisp
@@ -239,6 +240,13 @@ class Instance
         std::function<Atom(Atom prog, AtomMap *root_env, const std::string &name, bool only_compile)>
                     m_compile_func;
 
+        CompileCache m_compile_cache;
+        // Hashes of compiler.bklc and the primitive table layout:
+        std::string  m_compiler_key;
+
+        void init_compiler_key(const std::string &compiler_filepath);
+        void init_compile_func();
+
     public:
         Instance()
             : m_vm(&m_rt),
@@ -252,9 +260,27 @@ class Instance
 
         Runtime &get_runtime() { return m_rt; }
 
+        // Compiled programs of execute_file() are cached in dir_path,
+        // see CompileCache. An empty dir_path disables caching.
+        void set_compile_cache_dir(const std::string &dir_path)
+        { m_compile_cache.set_dir(dir_path); }
+
         void load_bootstrapped_compiler_from_disk();
+
+        // A heap snapshot holds the compiler after it was initialized
+        // by load_bootstrapped_compiler_from_disk(), with its root
+        // environment and already specialized PROGs. Restoring it skips
+        // running the compiler's toplevel and PROG::specialize().
+        // load_heap_snapshot() returns false if the snapshot is missing
+        // or does not fit compiler.bklc, the primitives or the opcodes.
+        bool load_heap_snapshot(const std::string &filepath);
+        bool save_heap_snapshot(const std::string &filepath);
         Atom execute_string(const std::string &line, AtomMap *root_env);
-        Atom execute_file(const std::string &filepath);
+        // Without root_env, the file gets a fresh root environment.
+        // Programs compiled in a given root_env are not cached, because
+        // they depend on its contents.
+        Atom execute_file(const std::string &filepath,
+                          AtomMap *root_env = nullptr);
         void load_module(BukaLISPModule *mod);
 
         ValueFactoryPtr create_value_factory()
@@ -5,6 +5,7 @@
 #include "buklivm.h"
 #include "atom_printer.h"
 #include "atom_cpp_serializer.h"
+#include "prog_image.h"
 #include "util.h"
 #include <chrono>
 #include <cmath>
@@ -30,9 +31,11 @@ namespace bukalisp
 
 //---------------------------------------------------------------------------
 
-#define SET_FRAME_ROW(row_ptr)  rr_frame = row_ptr;  rr_v_frame = rr_frame->m_data;
-#define SET_DATA_ROW(row_ptr)   rr_data  = row_ptr;  rr_v_data  = rr_data->m_data;
-#define SET_ROOT_ENV(vecptr)    root_env = (vecptr); rr_v_root  = root_env->m_data;
+// The current rows are written without write barrier, instead they
+// are remembered when they become current, see GC::mark_reg_row().
+#define SET_FRAME_ROW(row_ptr)  rr_frame = row_ptr;  rr_v_frame = rr_frame->m_data; gc_reg_row_barrier(rr_frame);
+#define SET_DATA_ROW(row_ptr)   rr_data  = row_ptr;  rr_v_data  = rr_data->m_data;  gc_reg_row_barrier(rr_data);
+#define SET_ROOT_ENV(vecptr)    root_env = (vecptr); rr_v_root  = root_env->m_data; gc_reg_row_barrier(root_env);
 
 //---------------------------------------------------------------------------
 
@@ -91,25 +94,67 @@ namespace bukalisp
         case REG_ROW_FRAME: rr_v_frame[(idx)] = (val); break; \
         case REG_ROW_DATA:  rr_v_data[(idx)]  = (val); break; \
         case REG_ROW_ROOT:  rr_v_root[(idx)]  = (val); break; \
-        case REG_ROW_UPV:   rr_v_frame[(idx)].m_d.vec->m_data[0] = (val); break; \
+        case REG_ROW_UPV: \
+        { \
+            AtomVec *upv = rr_v_frame[(idx)].m_d.vec; \
+            upv->m_data[0] = (val); \
+            gc_write_barrier(upv); \
+            break; \
+        } \
         case REG_ROW_RREF: \
         { \
-            size_t ridx = (size_t) rr_v_root[(idx)].m_d.vec->m_data[0].m_d.i; \
-            rr_v_root[(idx)].m_d.vec->m_data[1].m_d.vec->m_data[ridx] = (val); break; \
+            size_t ridx   = (size_t) rr_v_root[(idx)].m_d.vec->m_data[0].m_d.i; \
+            AtomVec *dest = rr_v_root[(idx)].m_d.vec->m_data[1].m_d.vec; \
+            dest->m_data[ridx] = (val); \
+            gc_write_barrier(dest); \
             break; \
         } \
     } \
 } while (0)
 //---------------------------------------------------------------------------
 
+// Needed after writing through a pointer from E_SET_D_PTR,
+// upvalues and root references are not in the current rows:
+#define E_WRITE_BARRIER_D(env_idx, idx) do { \
+    switch ((env_idx)) { \
+        case REG_ROW_UPV: \
+            gc_write_barrier(rr_v_frame[(idx)].m_d.vec); break; \
+        case REG_ROW_RREF: \
+            gc_write_barrier(rr_v_root[(idx)].m_d.vec->m_data[1].m_d.vec); break; \
+    } \
+} while (0)
+//---------------------------------------------------------------------------
+
 #define E_SET(reg, val)     E_SET_D(PE_##reg, P_##reg, (val))
 #define E_GET(out_ptr, reg) E_SET_D_PTR(PE_##reg, P_##reg, out_ptr)
 
+// Direct register access for the operand specialized opcodes,
+// the row is known from the opcode:
+#define E_PTR_F(reg)        (&(rr_v_frame[P_##reg]))
+#define E_PTR_D(reg)        (&(rr_v_data[P_##reg]))
+#define E_PTR_R(reg)        (&(rr_v_root[P_##reg]))
 //---------------------------------------------------------------------------
 
-#define RESTORE_FROM_CALL_FRAME(call_frame, ret_val)  \
+// Makes sure the current frame and root rows are as big
+// as the specialized instructions of the PROG expect them.
+#define PREPARE_PROG_ROWS(prog) do { \
+    if (rr_frame->m_len < (prog)->m_frame_size) \
+    { \
+        rr_frame->check_size((prog)->m_frame_size - 1); \
+        rr_v_frame = rr_frame->m_data; \
+    } \
+    if (root_env->m_len < (prog)->m_root_size) \
+    { \
+        root_env->check_size((prog)->m_root_size - 1); \
+        rr_v_root = root_env->m_data; \
+    } \
+} while (0)
+
+//---------------------------------------------------------------------------
+
+#define RESTORE_FROM_CALL_FRAME(call_frame_data, ret_val) \
     do {                                              \
-        Atom *cv = (call_frame).m_d.vec->m_data;      \
+        Atom *cv = (call_frame_data);                 \
         Atom &proc = cv[VM_CF_PROG];                  \
         if (   proc.m_type != T_UD                    \
             || proc.m_d.ud == nullptr)                \
@@ -134,7 +179,7 @@ namespace bukalisp
                                                       \
         E_SET_CHECK_REALLOC_D(eidx, oidx);            \
         E_SET_D(eidx, oidx, (ret_val));               \
-        if (m_trace)                                  \
+        if (VM_TRACE)                                 \
             cout << "RETURN(" << oidx << ":" << eidx  \
                  << ") => "                           \
                  << (ret_val).to_write_str() << endl; \
@@ -142,12 +187,10 @@ namespace bukalisp
 //---------------------------------------------------------------------------
 
 #define RECORD_CALL_FRAME(func, call_frame)             \
-    Atom call_frame(T_VEC,                              \
-        m_rt->m_gc.allocate_vector(VM_CALL_FRAME_SIZE));\
+    VMFrame *call_frame =                               \
+        cont_stack->push(VM_CALL_FRAME_SIZE);           \
     do {                                                \
-        AtomVec *cv = call_frame.m_d.vec;               \
-        cv->m_len = VM_CALL_FRAME_SIZE;                 \
-        Atom *data = cv->m_data;                        \
+        Atom *data = call_frame->m_data;                \
                                                         \
         data[VM_CF_CLOS].set_clos((func).m_d.vec);      \
         data[VM_CF_PROG].set_ud((UserData *) m_prog);   \
@@ -160,7 +203,7 @@ namespace bukalisp
 
 #define JUMP_TO_CLEANUP(exec_cleanup, cleanup_frame, cond_val, tag, ret_val) \
     do {                                                                \
-        AtomVec *clnup_frm = (cleanup_frame);                           \
+        VMFrame *clnup_frm = (cleanup_frame);                           \
         E_SET_CHECK_REALLOC_D(                                          \
             (clnup_frm)->m_data[VM_CLNUP_COND_E].m_d.i,                 \
             (clnup_frm)->m_data[VM_CLNUP_COND_I].m_d.i + 1);            \
@@ -185,6 +228,55 @@ namespace bukalisp
     } while(0)
 //---------------------------------------------------------------------------
 
+#define CONT_STACK_LAST() \
+    (cont_stack->m_len > cont_base ? cont_stack->last() : nullptr)
+//---------------------------------------------------------------------------
+
+// ops.cpp is included once for each variant of the dispatch loop
+// in VM::eval(). VM_OP() marks the start of the handler of an opcode,
+// for the threaded variant it also defines the label that
+// the handler addresses of the instructions point to.
+#define VM_OP_SWITCH(name)      case OP_##name:
+#define VM_OP_SWITCH_DEFAULT    default:
+#define VM_OP_THREADED(name)    case OP_##name: VM_LBL_##name:
+#define VM_OP_THREADED_DEFAULT  default: VM_LBL_DEFAULT:
+
+#if WITH_COMPUTED_GOTO
+#   define VM_THREAD_PROG(prog) \
+        do { if (!(prog)->m_threaded) (prog)->thread_code(s_op_labels); } while (0)
+#else
+#   define VM_THREAD_PROG(prog) do { } while (0)
+#endif
+
+// Replaces the opcode of the current instruction, see the
+// OP_QUICK_* opcodes in vmprog.h:
+#if WITH_COMPUTED_GOTO
+#   define VM_REWRITE_OP(new_op)                            \
+        do {                                                \
+            m_pc->op      = (uint8_t) (new_op);             \
+            m_pc->handler = s_op_labels[m_pc->op];          \
+        } while (0)
+#else
+#   define VM_REWRITE_OP(new_op) \
+        do { m_pc->op = (uint8_t) (new_op); } while (0)
+#endif
+
+#if WITH_QUICKENING
+#   define VM_QUICKEN(spec_op, ta, tb)                          \
+        do {                                                    \
+            if ((ta) == (tb))                                   \
+            {                                                   \
+                if ((ta) == T_INT)                              \
+                    VM_REWRITE_OP((spec_op) + OP_QUICK_II_OFFS);\
+                else if ((ta) == T_DBL)                         \
+                    VM_REWRITE_OP((spec_op) + OP_QUICK_DD_OFFS);\
+            }                                                   \
+        } while (0)
+#else
+#   define VM_QUICKEN(spec_op, ta, tb) do { } while (0)
+#endif
+//---------------------------------------------------------------------------
+
 void VM::init_prims()
 {
     Atom tmp;
@@ -281,33 +373,6 @@ void VM::report_arity_error(Atom &arity, size_t argc)
 }
 //---------------------------------------------------------------------------
 
-#define VM_CLNUP_FRAME_SIZE 5
-#define VM_CLNUP_PC     0
-#define VM_CLNUP_COND_I 1
-#define VM_CLNUP_COND_E 2
-#define VM_CLNUP_VAL_I  3
-#define VM_CLNUP_VAL_E  4
-
-#define VM_CLNUP_COND_UNDEF    0
-#define VM_CLNUP_COND_CTRL_JMP 1
-#define VM_CLNUP_COND_RETURN   2
-
-#define VM_JUMP_FRAME_SIZE 4
-#define VM_JMP_PC    0
-#define VM_JMP_TAG   1
-#define VM_JMP_OUT_I 2
-#define VM_JMP_OUT_E 3
-
-#define VM_CALL_FRAME_SIZE 6
-#define VM_CF_CLOS  0
-#define VM_CF_PROG  1
-#define VM_CF_FRAME 2
-#define VM_CF_ROOT  3
-#define VM_CF_PC    4
-#define VM_CF_OUT   5
-
-//---------------------------------------------------------------------------
-
 // TODO: For later
 //Atom dump_routine_state(
 //    GC &gc,
@@ -332,7 +397,8 @@ void VM::report_arity_error(Atom &arity, size_t argc)
 //}
 //---------------------------------------------------------------------------
 
-void walk_stack(PROG *cur_prog, INST *cur_pc, AtomVec *cont_stack,
+void walk_stack(PROG *cur_prog, INST *cur_pc,
+                VMContStack *cont_stack, size_t cont_base,
                 std::function<void(const std::string &place,
                                    const std::string &file_name,
                                    size_t line,
@@ -359,16 +425,9 @@ void walk_stack(PROG *cur_prog, INST *cur_pc, AtomVec *cont_stack,
 
     PROG *last_prog = cur_prog;
 
-    for (size_t i = cont_stack->m_len; i > 0; i--)
+    for (size_t i = cont_stack->m_len; i > cont_base; i--)
     {
-        Atom &frame = cont_stack->m_data[i - 1];
-        if (frame.m_type != T_VEC)
-        {
-            walk_func("prog@?", "?", 0, frame.to_write_str());
-            continue;
-        }
-
-        AtomVec *f = frame.m_d.vec;
+        VMFrame *f = cont_stack->at(i - 1);
 
         switch (f->m_len)
         {
@@ -458,21 +517,22 @@ void walk_stack(PROG *cur_prog, INST *cur_pc, AtomVec *cont_stack,
 }
 //---------------------------------------------------------------------------
 
-Atom dump_stack_trace(GC &gc, AtomVec *cont_stack, PROG *cur_prog, INST *cur_pc)
+Atom dump_stack_trace(GC &gc, VMContStack *cont_stack, size_t cont_base,
+                      PROG *cur_prog, INST *cur_pc)
 {
     AtomVec *frms = gc.allocate_vector(10);
 
-    walk_stack(cur_prog, cur_pc, cont_stack,
+    walk_stack(cur_prog, cur_pc, cont_stack, cont_base,
         [&](const std::string &place,
             const std::string &file_name,
             size_t line,
             const std::string &func_name)
         {
             AtomVec *frm = gc.allocate_vector(4);
-            frm->push(Atom(T_STR, gc.new_symbol(place)));
-            frm->push(Atom(T_STR, gc.new_symbol(file_name)));
+            frm->push(Atom(T_STR, gc.new_string(place)));
+            frm->push(Atom(T_STR, gc.new_string(file_name)));
             frm->push(Atom(T_INT, line));
-            frm->push(Atom(T_STR, gc.new_symbol(func_name)));
+            frm->push(Atom(T_STR, gc.new_string(func_name)));
             frms->push(Atom(T_VEC, frm));
         });
 
@@ -502,7 +562,6 @@ Atom VM::eval(Atom callable, AtomVec *args)
     if (!args) args = m_rt->m_gc.allocate_vector(0);
 
     GC_ROOT_VEC(m_rt->m_gc, args_root)     = args;
-    GC_ROOT_VEC(m_rt->m_gc, cont_stack)    = nullptr;
     GC_ROOT_VEC(m_rt->m_gc, empty_upv_row) = m_rt->m_gc.allocate_vector(0);
     AtomVec *clos_upvalues = empty_upv_row;
 
@@ -514,6 +573,7 @@ Atom VM::eval(Atom callable, AtomVec *args)
         SET_DATA_ROW(prog->m_data_vec);
         SET_FRAME_ROW(args);
         SET_ROOT_ENV(prog->m_root_regs);
+        PREPARE_PROG_ROWS(prog);
     }
     else if (callable.m_type == T_CLOS)
     {
@@ -567,23 +627,49 @@ Atom VM::eval(Atom callable, AtomVec *args)
         return Atom();
     }
 
+#if WITH_COMPUTED_GOTO
+    static void *s_op_labels[256];
+    static bool  s_op_labels_init = false;
+    if (!s_op_labels_init)
+    {
+        for (size_t i = 0; i < 256; i++)
+            s_op_labels[i] = &&VM_LBL_DEFAULT;
+#       define X(name, code) s_op_labels[code] = &&VM_LBL_##name;
+#       define XS(name, code, base) X(name, code)
+        OP_CODE_DEF(X)
+        OP_SPEC_CODE_DEF(XS)
+#       undef XS
+#       undef X
+        s_op_labels_init = true;
+    }
+#endif
+
+    if (prog)
+        VM_THREAD_PROG(prog);
+
     cout << "vm start" << endl;
 
     VMProgStateGuard psg(m_prog, m_pc, prog, pc);
 
+    // Nested calls of VM::eval() share the continuation stack of the VM.
+    // Everything below cont_base belongs to the outer eval and
+    // is restored by the guard when we leave.
+    VMContStack     *cont_stack = m_cont_stack;
+    VMContStackGuard cont_stack_guard(cont_stack);
+    size_t           cont_base  = cont_stack_guard.base();
+
     // XXX: The root-call-frame actually keeps alive the whole code-tree, including
     //      any callable sub-m_prog objects. Thus, we don't have to explicitly
     //      keep alive the m-prog or it's m_atom_data
     //
     //      Also it keeps alive the dummy rr_frame that is used to
     //      call a T_CLOS that was passed to VM::eval().
-    cont_stack = m_rt->m_gc.allocate_vector(7);
     {
-        AtomVec *call_frame = m_rt->m_gc.allocate_vector(VM_CALL_FRAME_SIZE);
-        call_frame->set(VM_CF_CLOS, callable);
-        call_frame->set(VM_CF_FRAME, Atom(T_VEC, rr_frame));
-        call_frame->set(VM_CALL_FRAME_SIZE - 1, Atom());
-        cont_stack->push(Atom(T_VEC, call_frame));
+        VMFrame *call_frame = cont_stack->push(VM_CALL_FRAME_SIZE);
+        for (size_t i = 0; i < VM_CALL_FRAME_SIZE; i++)
+            call_frame->m_data[i].clear();
+        call_frame->m_data[VM_CF_CLOS]  = callable;
+        call_frame->m_data[VM_CF_FRAME] = Atom(T_VEC, rr_frame);
     }
 
 //    cout << "VM PROG: " << callable.to_write_str() << endl;
@@ -595,12 +681,14 @@ Atom VM::eval(Atom callable, AtomVec *args)
     Atom *tmp = nullptr;
 
     bool alloc = false;
+    // Set by OP_TAILCALL for the OP_CALL handler it falls through to:
+    bool tail_call = false;
     VM_START:
     try
     {
-        while (m_pc->op != OP_END)
+        if (m_trace)
         {
-            if (m_trace)
+            while (m_pc->op != OP_END)
             {
                 cout << "VMTRC FRMS(" << cont_stack->m_len << "): ";
                 Atom pc_a = m_pc->to_atom(m_rt->m_gc);
@@ -621,15 +709,65 @@ Atom VM::eval(Atom callable, AtomVec *args)
                 }
                 cout << "} " << (m_prog ? m_prog->m_function_info : std::string()) << " "
                      << get_current_debug_info().to_write_str() << endl;
+
+#               define VM_TRACE          m_trace
+#               define VM_OP(name)       VM_OP_SWITCH(name)
+#               define VM_OP_DEFAULT     VM_OP_SWITCH_DEFAULT
+#               include "ops.cpp"
+#               undef VM_OP_DEFAULT
+#               undef VM_OP
+#               undef VM_TRACE
+
+                if (alloc)
+                {
+                    m_rt->m_gc.collect_maybe();
+                    alloc = false;
+                }
             }
+        }
+        else
+        {
+#if WITH_COMPUTED_GOTO
+            instant_operation.handler = s_op_labels[instant_operation.op];
+
+        VM_DISPATCH:
+            goto *(m_pc->handler);
 
+#           define VM_TRACE          false
+#           define VM_OP(name)       VM_OP_THREADED(name)
+#           define VM_OP_DEFAULT     VM_OP_THREADED_DEFAULT
 #           include "ops.cpp"
+#           undef VM_OP_DEFAULT
+#           undef VM_OP
+#           undef VM_TRACE
 
             if (alloc)
             {
                 m_rt->m_gc.collect_maybe();
                 alloc = false;
             }
+            goto VM_DISPATCH;
+
+        VM_LBL_END:
+            ;
+#else
+            while (m_pc->op != OP_END)
+            {
+#               define VM_TRACE          false
+#               define VM_OP(name)       VM_OP_SWITCH(name)
+#               define VM_OP_DEFAULT     VM_OP_SWITCH_DEFAULT
+#               include "ops.cpp"
+#               undef VM_OP_DEFAULT
+#               undef VM_OP
+#               undef VM_TRACE
+
+                if (alloc)
+                {
+                    m_rt->m_gc.collect_maybe();
+                    alloc = false;
+                }
+            }
+#endif
         }
     }
     catch (VMRaise &)
@@ -641,7 +779,8 @@ Atom VM::eval(Atom callable, AtomVec *args)
         if (!e.has_stack_trace())
         {
             Atom stk_trc =
-                dump_stack_trace(m_rt->m_gc, cont_stack, m_prog, m_pc);
+                dump_stack_trace(
+                    m_rt->m_gc, cont_stack, cont_base, m_prog, m_pc);
             e.push(stk_trc);
         }
 
@@ -7,6 +7,7 @@
 #include "atom_userdata.h"
 #include "runtime.h"
 #include <sstream>
+#include <vector>
 #include "vmprog.h"
 
 //---------------------------------------------------------------------------
@@ -19,6 +20,36 @@ class BukaLISPModule;
 #define VM_CLOS_IS_CORO  2
 #define VM_CLOS_ARITY    3
 
+#define VM_CLNUP_FRAME_SIZE 5
+#define VM_CLNUP_PC     0
+#define VM_CLNUP_COND_I 1
+#define VM_CLNUP_COND_E 2
+#define VM_CLNUP_VAL_I  3
+#define VM_CLNUP_VAL_E  4
+
+#define VM_CLNUP_COND_UNDEF    0
+#define VM_CLNUP_COND_CTRL_JMP 1
+#define VM_CLNUP_COND_RETURN   2
+
+#define VM_JUMP_FRAME_SIZE 4
+#define VM_JMP_PC    0
+#define VM_JMP_TAG   1
+#define VM_JMP_OUT_I 2
+#define VM_JMP_OUT_E 3
+
+#define VM_CALL_FRAME_SIZE 6
+#define VM_CF_CLOS  0
+#define VM_CF_PROG  1
+#define VM_CF_FRAME 2
+#define VM_CF_ROOT  3
+#define VM_CF_PC    4
+#define VM_CF_OUT   5
+
+// Register rows that were allocated by OP_CALL are recycled on return.
+// These limit how many rows are kept around and how big they may be.
+#define VM_ROW_POOL_MAX       256
+#define VM_ROW_POOL_MAX_ALLOC 128
+
 //---------------------------------------------------------------------------
 
 namespace bukalisp
@@ -46,6 +77,152 @@ class VMRaise : public std::exception
 //---------------------------------------------------------------------------
 
 
+/* A frame on the continuation stack of the VM. The layout of m_data
+ * is the same as the layout of the AtomVec frames, that are created
+ * when a coroutine yields (see VMFrame::to_atom). The kind of the frame
+ * is given by m_len, which is one of VM_CALL_FRAME_SIZE,
+ * VM_JUMP_FRAME_SIZE or VM_CLNUP_FRAME_SIZE.
+ */
+struct VMFrame
+{
+    size_t  m_len;
+    // true if the callee register row was allocated by this call,
+    // and may be given back to the VMContStack on return:
+    bool    m_own_row;
+    Atom    m_data[VM_CALL_FRAME_SIZE];
+
+    Atom to_atom(GC &gc) const
+    {
+        AtomVec *v = gc.allocate_vector(m_len);
+        for (size_t i = 0; i < m_len; i++)
+            v->m_data[i] = m_data[i];
+        v->m_len = m_len;
+        return Atom(T_VEC, v);
+    }
+
+    void from_atom(const Atom &a)
+    {
+        m_own_row = false;
+        m_len     = a.m_d.vec->m_len;
+        if (m_len > VM_CALL_FRAME_SIZE)
+            m_len = VM_CALL_FRAME_SIZE;
+        for (size_t i = 0; i < m_len; i++)
+            m_data[i] = a.m_d.vec->m_data[i];
+    }
+};
+//---------------------------------------------------------------------------
+
+/* The continuation stack of the VM. Call, jump and cleanup frames live
+ * in one contiguous block of memory that is owned by the VM, instead
+ * of being allocated as AtomVecs on the GC heap. The stack is marked
+ * as a GC root by itself. Frames are only copied to the heap if a
+ * coroutine yields and needs to take them along.
+ *
+ * The stack also keeps a small pool of register rows, which OP_CALL
+ * uses for the argument frames of closure calls.
+ */
+class VMContStack : public UserData
+{
+    public:
+        std::vector<VMFrame>    m_frames;
+        size_t                  m_len;
+        std::vector<AtomVec *>  m_free_rows;
+
+        VMContStack() : m_len(0)
+        {
+            m_frames.resize(64);
+        }
+
+        VMFrame *push(size_t frame_len)
+        {
+            if (m_len >= m_frames.size())
+                m_frames.resize(m_frames.size() * 2);
+            VMFrame *f   = &(m_frames[m_len++]);
+            f->m_len     = frame_len;
+            f->m_own_row = false;
+            return f;
+        }
+
+        void push(const Atom &heap_frame)
+        {
+            push(0)->from_atom(heap_frame);
+        }
+
+        VMFrame *last()
+        {
+            if (m_len <= 0) return nullptr;
+            return &(m_frames[m_len - 1]);
+        }
+
+        VMFrame *at(size_t idx) { return &(m_frames[idx]); }
+
+        void pop() { if (m_len > 0) m_len--; }
+
+        AtomVec *take_row(GC &gc, size_t alloc_len)
+        {
+            if (m_free_rows.empty())
+                return gc.allocate_vector(alloc_len);
+
+            AtomVec *row = m_free_rows.back();
+            m_free_rows.pop_back();
+            if (row->m_alloc < alloc_len)
+            {
+                row->m_len = 0;
+                row->check_size(alloc_len - 1);
+            }
+            return row;
+        }
+
+        void give_back_row(AtomVec *row)
+        {
+            if (   m_free_rows.size() >= VM_ROW_POOL_MAX
+                || row->m_alloc > VM_ROW_POOL_MAX_ALLOC)
+                return;
+            row->m_len = 0;
+            m_free_rows.push_back(row);
+        }
+
+        virtual std::string type() { return "BKL-VM-CONT-STACK"; }
+        virtual std::string as_string(bool pretty = false)
+        { return "#<vm-cont-stack>"; }
+
+        virtual void mark(GC *gc, uint8_t clr)
+        {
+            UserData::mark(gc, clr);
+            for (size_t i = 0; i < m_len; i++)
+            {
+                VMFrame &f = m_frames[i];
+                for (size_t j = 0; j < f.m_len; j++)
+                    gc->mark_atom(f.m_data[j]);
+            }
+            for (auto row : m_free_rows)
+                gc->mark_atom(Atom(T_VEC, row));
+        }
+
+        virtual ~VMContStack() { }
+};
+//---------------------------------------------------------------------------
+
+class VMContStackGuard
+{
+    private:
+        VMContStack *m_stack;
+        size_t       m_base;
+    public:
+        VMContStackGuard(VMContStack *stack)
+            : m_stack(stack), m_base(stack->m_len)
+        {
+        }
+
+        size_t base() const { return m_base; }
+
+        ~VMContStackGuard()
+        {
+            m_stack->m_len = m_base;
+        }
+};
+//---------------------------------------------------------------------------
+
 class VMProgStateGuard
 {
     private:
@@ -86,6 +263,8 @@ class VM
         std::function<Atom(Atom func, AtomVec *args)> m_interpreter_call;
         typedef std::function<Atom(Atom prog, AtomMap *root_env, const std::string &input_name, bool only_compile)> compiler_func;
         compiler_func m_compiler_call;
+        VMContStack  *m_cont_stack;
+        GC_ROOT_MEMBER(m_cont_stack_root);
 
     public:
         Runtime   *m_rt;
@@ -99,8 +278,12 @@ class VM
               GC_ROOT_MEMBER_INITALIZE_VEC(rt->m_gc, m_prim_table),
               GC_ROOT_MEMBER_INITALIZE_VEC(rt->m_gc, m_prim_sym_table),
               GC_ROOT_MEMBER_INITALIZE_MAP(rt->m_gc, m_modules),
-              GC_ROOT_MEMBER_INITALIZE_MAP(rt->m_gc, m_documentation)
+              GC_ROOT_MEMBER_INITALIZE_MAP(rt->m_gc, m_documentation),
+              GC_ROOT_MEMBER_INITALIZE(rt->m_gc, m_cont_stack_root)
         {
+            m_cont_stack      = new VMContStack;
+            m_cont_stack_root = Atom(T_UD, m_cont_stack);
+
             m_prim_table     = rt->m_gc.allocate_vector(0);
             m_prim_sym_table = rt->m_gc.allocate_vector(0);
             m_modules        = rt->m_gc.allocate_map();
@@ -136,7 +319,7 @@ class VM
         {
             set_documentation(
                 Atom(T_SYM, m_rt->m_gc.new_symbol(func_name)),
-                Atom(T_STR, m_rt->m_gc.new_symbol(doc_string)));
+                Atom(T_STR, m_rt->m_gc.new_string(doc_string)));
         }
 
         Atom get_documentation() { return Atom(T_MAP, m_documentation); }
@@ -232,6 +415,9 @@ class VM
                 if (m_prim_table->at(i).m_type == T_PRIM)
                     delete m_prim_table->at(i).m_d.func;
             }
+
+            m_cont_stack_root = Atom();
+            delete m_cont_stack;
         }
 
         Atom eval(Atom at_ud, AtomVec *args = nullptr);
@@ -0,0 +1,177 @@
+// Copyright (C) 2017 Weird Constructor
+// For more license info refer to the the bottom of this file.
+
+#include "compile_cache.h"
+#include "prog_image.h"
+#include "util.h"
+#include <cstdio>
+
+using namespace std;
+
+namespace bukalisp
+{
+//---------------------------------------------------------------------------
+
+std::string hash_to_hex(const std::string &data, uint64_t seed)
+{
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx",
+             (unsigned long long) hash_fnv1a(data, seed));
+    return std::string(buf);
+}
+//---------------------------------------------------------------------------
+
+void CompileCache::set_dir(const std::string &dir_path)
+{
+    m_dir = dir_path;
+    if (!m_dir.empty() && !create_dir(m_dir))
+        throw BukaLISPException(
+            "Couldn't create compile cache directory '" + m_dir + "'");
+}
+//---------------------------------------------------------------------------
+
+void CompileCache::set_compiler_key(
+    const std::string &compiler_image,
+    const std::string &prim_layout)
+{
+    m_compiler_key =
+        hash_to_hex(compiler_image)
+        + hash_to_hex(prim_layout)
+        + to_string(BKL_PROG_IMAGE_VERSION);
+}
+//---------------------------------------------------------------------------
+
+std::string CompileCache::entry_key(
+    const std::string &input_name,
+    const std::string &source)
+{
+    std::string key_data = m_compiler_key;
+    key_data += '\0';
+    key_data += input_name;
+    key_data += '\0';
+    key_data += source;
+
+    // Two differently seeded hashes make accidental collisions
+    // of 64 bit hashes a non-issue:
+    return hash_to_hex(key_data) + hash_to_hex(key_data, 1);
+}
+//---------------------------------------------------------------------------
+
+std::string CompileCache::entry_path(const std::string &key)
+{
+    return m_dir + BKL_PATH_SEP + key + ".bklc";
+}
+//---------------------------------------------------------------------------
+
+Atom CompileCache::load(
+    GC &gc,
+    const std::string &input_name,
+    const std::string &source)
+{
+    if (!enabled())
+        return Atom();
+
+    std::string key  = entry_key(input_name, source);
+    std::string path = entry_path(key);
+    if (!is_prog_image_file(path))
+        return Atom();
+
+    Atom entry;
+    try
+    {
+        entry = load_prog_image_file(gc, path);
+    }
+    catch (BukaLISPException &)
+    {
+        // Broken entries are just overwritten by the next store():
+        return Atom();
+    }
+
+    if (   entry.m_type != T_VEC
+        || entry.m_d.vec->m_len != 3
+        || entry.at(0).m_type != T_STR
+        || entry.at(0).m_d.sym->m_str != key
+        || entry.at(1).m_type != T_VEC)
+        return Atom();
+
+    AtomVec *read_files = entry.at(1).m_d.vec;
+    for (size_t i = 0; i + 1 < read_files->m_len; i += 2)
+    {
+        if (   read_files->m_data[i].m_type     != T_STR
+            || read_files->m_data[i + 1].m_type != T_STR)
+            return Atom();
+
+        const std::string &file_path = read_files->m_data[i].m_d.sym->m_str;
+        if (!file_exists(file_path))
+            return Atom();
+
+        if (hash_to_hex(slurp_str(file_path))
+            != read_files->m_data[i + 1].m_d.sym->m_str)
+            return Atom();
+    }
+
+    return entry.at(2);
+}
+//---------------------------------------------------------------------------
+
+bool CompileCache::store(
+    GC &gc,
+    const std::string &input_name,
+    const std::string &source,
+    const std::vector<std::string> &read_files,
+    const Atom &prog)
+{
+    if (!enabled())
+        return false;
+
+    std::string key = entry_key(input_name, source);
+
+    GC_ROOT_VEC(gc, entry) = gc.allocate_vector(3);
+    entry->push(Atom(T_STR, gc.new_string(key)));
+
+    AtomVec *files = gc.allocate_vector(read_files.size() * 2);
+    entry->push(Atom(T_VEC, files));
+    for (auto &file_path : read_files)
+    {
+        files->push(Atom(T_STR, gc.new_string(file_path)));
+        files->push(Atom(T_STR, gc.new_string(
+            hash_to_hex(slurp_str(file_path)))));
+    }
+
+    entry->push(prog);
+
+    try
+    {
+        return save_prog_image_file(gc, entry_path(key), Atom(T_VEC, entry));
+    }
+    catch (BukaLISPException &)
+    {
+        return false;
+    }
+}
+//---------------------------------------------------------------------------
+
+}
+
+/******************************************************************************
+* Copyright (C) 2017 Weird Constructor
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
@@ -0,0 +1,82 @@
+// Copyright (C) 2017 Weird Constructor
+// For more license info refer to the the bottom of this file.
+
+#pragma once
+
+#include "atom.h"
+
+namespace bukalisp
+{
+//---------------------------------------------------------------------------
+
+// On disk cache of compiled programs. Each entry is a binary PROG image
+// (see prog_image.h) in the cache directory, its file name is a hash of
+// the source text, the input name and the compiler key. The compiler key
+// covers the compiler image and the primitive table layout.
+//
+// An entry also records the files that were read while compiling
+// (for example by 'include') with their content hash. The entry is
+// only used, if none of them changed.
+class CompileCache
+{
+    private:
+        std::string m_dir;
+        std::string m_compiler_key;
+
+        std::string entry_key(const std::string &input_name,
+                              const std::string &source);
+        std::string entry_path(const std::string &key);
+
+    public:
+        // An empty dir_path disables the cache, the directory
+        // is created if it does not exist yet.
+        void set_dir(const std::string &dir_path);
+        bool enabled() const { return !m_dir.empty(); }
+
+        void set_compiler_key(const std::string &compiler_image,
+                              const std::string &prim_layout);
+
+        // Returns the cached PROG or an Atom of type T_NIL
+        // if there is no up to date entry.
+        Atom load(GC &gc,
+                  const std::string &input_name,
+                  const std::string &source);
+
+        // Returns false if prog could not be stored, for instance
+        // because it refers to primitives of VM modules.
+        bool store(GC &gc,
+                   const std::string &input_name,
+                   const std::string &source,
+                   const std::vector<std::string> &read_files,
+                   const Atom &prog);
+};
+//---------------------------------------------------------------------------
+
+// hash_fnv1a() of data as 16 hex digits.
+std::string hash_to_hex(const std::string &data, uint64_t seed = 0);
+
+//---------------------------------------------------------------------------
+}
+
+/******************************************************************************
+* Copyright (C) 2017 Weird Constructor
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
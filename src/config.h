@@ -31,11 +31,80 @@
 #define GC_DEBUG_MODE 0
 //---------------------------------------------------------------------------
 
+// Number of vectors, maps and userdata objects that are allocated in the
+// nursery of the generational GC, before a minor collection is done.
+// Bigger values mean less minor collections, but longer pauses.
+#if GC_DEBUG_MODE
+#   define GC_NURSERY_SIZE 256
+#else
+#   define GC_NURSERY_SIZE 8192
+#endif
+//---------------------------------------------------------------------------
+
+// Maximum time in microseconds, that one step of the incremental
+// marking of a major collection may take. The mark is spread over
+// the allocations of the program. 0 does the whole major collection
+// at once. Can be changed at runtime with (bkl-gc-pause-budget).
+#define GC_PAUSE_BUDGET_US 1000
+
+// Number of objects that are marked between checks of the clock.
+#define GC_MARK_STEP_WORK  256
+
+// Number of threads that mark major collections. With more than one
+// thread, major collections are done at once, without the pause budget.
+// Can be changed at runtime with (bkl-gc-mark-threads).
+#define GC_MARK_THREADS    1
+
+// Heaps with fewer vectors and maps are marked by one thread, because
+// waking up the other threads would take longer than the mark:
+#define GC_PARALLEL_MARK_MIN_OBJECTS 50000
+
+// Major collections only sweep the nursery in the pause, the old
+// objects are swept in steps of GC_SWEEP_STEP_WORK objects by the
+// following allocations (see GC::sweep_step()):
+#define GC_LAZY_SWEEP       1
+#define GC_SWEEP_STEP_WORK  64
+
+// A major collection is done when the heap grew to GC_HEAP_GROWTH
+// times the bytes that survived the last one. The heap is allowed to
+// grow to GC_HEAP_MIN_BYTES in any case. If GC_HEAP_SOFT_LIMIT_BYTES
+// is not 0, the GC collects more often when the heap gets near it.
+// Can be changed at runtime with (bkl-gc-heap-growth), (bkl-gc-heap-min)
+// and (bkl-gc-heap-soft-limit).
+#define GC_HEAP_GROWTH            2.0
+#define GC_HEAP_MIN_BYTES         (8 * 1024 * 1024)
+#define GC_HEAP_SOFT_LIMIT_BYTES  0
+//---------------------------------------------------------------------------
+
 // Disables usage of modules:
 #define USE_MODULES 1
 
 //---------------------------------------------------------------------------
 
+// If enabled, the VM pre-decodes the instructions of a PROG into the
+// addresses of their handlers and dispatches with direct threaded
+// code (computed goto). This needs the "labels as values" extension
+// of GCC and Clang, other compilers fall back to the plain switch.
+#if defined(__GNUC__)
+#   define WITH_COMPUTED_GOTO 1
+#else
+#   define WITH_COMPUTED_GOTO 0
+#endif
+
+// If enabled, the register specialized arithmetic and comparison
+// instructions (eg. ADD_FFF) rewrite themselves into a variant for
+// the operand types they saw (eg. ADD_FFF_II for two integers).
+// That variant only checks the types and falls back to the
+// generic variant, if they don't match anymore.
+#define WITH_QUICKENING 1
+
+// If enabled, PROG::specialize() fuses common pairs of instructions
+// into one superinstruction (eg. LT_FFF followed by BRIF_F into
+// LT_FFF_BRIF), which saves one dispatch per pair.
+#define WITH_SUPERINSTRUCTIONS 1
+
+//---------------------------------------------------------------------------
+
 #if defined(WIN32) || defined(_WIN32)
 #   define BKL_PATH_SEP    "\\"
 #else
@@ -0,0 +1,195 @@
+// Copyright (C) 2017 Weird Constructor
+// For more license info refer to the the bottom of this file.
+
+#include "fork_server.h"
+#include <cstdio>
+
+#if !(defined(WIN32) || defined(_WIN32))
+extern "C"
+{
+#  include <errno.h>
+#  include <signal.h>
+#  include <string.h>
+#  include <sys/socket.h>
+#  include <sys/un.h>
+#  include <unistd.h>
+}
+#endif
+
+using namespace std;
+
+namespace bukalisp
+{
+//---------------------------------------------------------------------------
+
+// Maximum length of the script path a client may send:
+#define FORK_SERVER_MAX_REQUEST   4096
+// Pending connections of the listening socket:
+#define FORK_SERVER_BACKLOG       64
+//---------------------------------------------------------------------------
+
+#if defined(WIN32) || defined(_WIN32)
+
+void run_fork_server(Instance &, const std::string &, AtomMap *)
+{
+    throw BukaLISPException(
+        "The fork server is not supported on this platform");
+}
+
+#else
+
+static std::string read_request_line(int fd)
+{
+    std::string line;
+    char c;
+    while (line.size() < FORK_SERVER_MAX_REQUEST)
+    {
+        ssize_t n = read(fd, &c, 1);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0 || c == '\n')
+            break;
+        line += c;
+    }
+
+    if (!line.empty() && line[line.size() - 1] == '\r')
+        line.resize(line.size() - 1);
+
+    return line;
+}
+//---------------------------------------------------------------------------
+
+// Runs in the forked child, the connection becomes its stdout and stderr.
+static void run_job(Instance &inst, AtomMap *root_env, int conn)
+{
+    std::string filepath = read_request_line(conn);
+
+    dup2(conn, 1);
+    dup2(conn, 2);
+    close(conn);
+
+    int status = 0;
+    try
+    {
+        Atom r = inst.execute_file(filepath, root_env);
+        cout << r.to_write_str(true) << endl;
+    }
+    catch (VMRaise &r)
+    {
+        Atom err_obj = r.get_error_obj();
+        if (BukaLISPException::is_error_object(err_obj))
+            BukaLISPException::print_error_object(err_obj, cerr);
+        else
+            cerr << "Uncaught raised atom: "
+                 << err_obj.to_write_str(true) << endl;
+        status = 1;
+    }
+    catch (std::exception &e)
+    {
+        cerr << "[" << filepath << "] Exception: " << e.what() << endl;
+        status = 1;
+    }
+
+    // _exit() skips the destructors, they would only free the
+    // memory shared with the server:
+    cout.flush();
+    cerr.flush();
+    fflush(stdout);
+    fflush(stderr);
+    _exit(status);
+}
+//---------------------------------------------------------------------------
+
+void run_fork_server(Instance &inst,
+                     const std::string &socket_path,
+                     AtomMap *root_env)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path))
+        throw BukaLISPException(
+            "Fork server socket path too long: '" + socket_path + "'");
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int srv = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (srv < 0)
+        throw BukaLISPException(
+            std::string("Couldn't create fork server socket: ")
+            + strerror(errno));
+
+    unlink(socket_path.c_str());
+    if (   bind(srv, (struct sockaddr *) &addr, sizeof(addr)) < 0
+        || listen(srv, FORK_SERVER_BACKLOG) < 0)
+    {
+        std::string err = strerror(errno);
+        close(srv);
+        throw BukaLISPException(
+            "Couldn't listen on '" + socket_path + "': " + err);
+    }
+
+    // The children are reaped by the system:
+    signal(SIGCHLD, SIG_IGN);
+
+    inst.get_runtime().m_gc.freeze();
+
+    cout << "fork server listening on " << socket_path << endl;
+    // Buffered output would be written by every child again:
+    cout.flush();
+    cerr.flush();
+    fflush(stdout);
+    fflush(stderr);
+
+    for (;;)
+    {
+        int conn = accept(srv, nullptr, nullptr);
+        if (conn < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            std::string err = strerror(errno);
+            close(srv);
+            throw BukaLISPException("Fork server accept failed: " + err);
+        }
+
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(srv);
+            signal(SIGCHLD, SIG_DFL);
+            run_job(inst, root_env, conn);
+        }
+        else if (pid < 0)
+            cerr << "fork server: fork failed: " << strerror(errno) << endl;
+
+        close(conn);
+    }
+}
+
+#endif
+//---------------------------------------------------------------------------
+
+}
+
+/******************************************************************************
+* Copyright (C) 2017 Weird Constructor
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
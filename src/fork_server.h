@@ -0,0 +1,54 @@
+// Copyright (C) 2017 Weird Constructor
+// For more license info refer to the the bottom of this file.
+
+#pragma once
+
+#include "bukalisp.h"
+
+namespace bukalisp
+{
+//---------------------------------------------------------------------------
+
+// Runs the jobs of 'bklisp --fork-server' and does not return, unless
+// the socket could not be set up.
+//
+// The heap of inst is frozen first (see GC::freeze()), then the server
+// accepts connections on the Unix domain socket at socket_path. A client
+// sends the path of a script file, terminated by a newline. The server
+// forks a child process, which runs the script with
+// Instance::execute_file() in root_env and writes the output and the
+// result of the script to the connection. The connection is closed when
+// the child exits.
+//
+// The child shares the compiler and everything in root_env with the
+// server. As the collections in the child do not write to the frozen
+// objects, their pages are only copied if the script modifies them.
+void run_fork_server(Instance &inst,
+                     const std::string &socket_path,
+                     AtomMap *root_env);
+
+//---------------------------------------------------------------------------
+}
+
+/******************************************************************************
+* Copyright (C) 2017 Weird Constructor
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
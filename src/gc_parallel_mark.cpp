@@ -0,0 +1,441 @@
+// Copyright (C) 2017 Weird Constructor
+// For more license info refer to the the bottom of this file.
+
+#include "gc_parallel_mark.h"
+#include "atom.h"
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+namespace bukalisp
+{
+//---------------------------------------------------------------------------
+
+// A thread moves half of its private stack to its shared deque,
+// when the stack has more entries than this and the deque is empty:
+#define GC_PAR_SHARE_MIN     32
+// Large vectors are shared while they are scanned every this many elements:
+#define GC_PAR_SCAN_CHUNK    1024
+//---------------------------------------------------------------------------
+
+// Sets the color of an object, returns true if it had another color before.
+static inline bool gc_par_try_color(uint8_t *clr, uint8_t new_clr)
+{
+#if defined(_MSC_VER)
+    char old = *((volatile char *) clr);
+    while (old != (char) new_clr)
+    {
+        char prev =
+            _InterlockedCompareExchange8((char *) clr, (char) new_clr, old);
+        if (prev == old)
+            return true;
+        old = prev;
+    }
+    return false;
+#else
+    uint8_t old = __atomic_load_n(clr, __ATOMIC_RELAXED);
+    while (old != new_clr)
+    {
+        if (__atomic_compare_exchange_n(
+                clr, &old, new_clr, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            return true;
+    }
+    return false;
+#endif
+}
+//---------------------------------------------------------------------------
+
+static inline uint8_t gc_par_get_color(uint8_t *clr)
+{
+#if defined(_MSC_VER)
+    return (uint8_t) *((volatile char *) clr);
+#else
+    return __atomic_load_n(clr, __ATOMIC_RELAXED);
+#endif
+}
+//---------------------------------------------------------------------------
+
+static inline void gc_par_set_color(uint8_t *clr, uint8_t new_clr)
+{
+#if defined(_MSC_VER)
+    *((volatile char *) clr) = (char) new_clr;
+#else
+    __atomic_store_n(clr, new_clr, __ATOMIC_RELAXED);
+#endif
+}
+//---------------------------------------------------------------------------
+
+// Sets bit idx, returns true if it was not set before.
+static inline bool gc_par_try_set_bit(uint64_t *bits, uint32_t idx)
+{
+    uint64_t bit = ((uint64_t) 1) << (idx & 63);
+#if defined(_MSC_VER)
+    return !(_InterlockedOr64(
+                (volatile __int64 *) &bits[idx >> 6], (__int64) bit) & bit);
+#else
+    return !(__atomic_fetch_or(&bits[idx >> 6], bit, __ATOMIC_ACQ_REL) & bit);
+#endif
+}
+//---------------------------------------------------------------------------
+
+// Marks obj, returns true if it was not marked before. The color of
+// frozen objects never changes, so it can be read without a race.
+template<typename T>
+static inline bool gc_par_try_mark(T *obj, uint8_t color, uint64_t *side_marks)
+{
+    if (gc_par_get_color(&obj->m_gc_color) == GC_COLOR_FROZEN)
+        return gc_par_try_set_bit(side_marks, obj->m_gc_side_idx);
+    return gc_par_try_color(&obj->m_gc_color, color);
+}
+//---------------------------------------------------------------------------
+
+GCParallelMarker::GCParallelMarker(size_t num_threads)
+    : m_round(0), m_num_done(0), m_quit(false),
+      m_num_active(0), m_found_free(false), m_color(0),
+      m_side_marks(nullptr)
+{
+    if (num_threads < 1) num_threads = 1;
+
+    for (size_t i = 0; i < num_threads; i++)
+        m_workers.push_back(std::unique_ptr<Worker>(new Worker));
+
+    // Worker 0 is the thread that calls mark():
+    for (size_t i = 1; i < num_threads; i++)
+        m_threads.push_back(std::thread([this, i]() { thread_main(i); }));
+}
+//---------------------------------------------------------------------------
+
+GCParallelMarker::~GCParallelMarker()
+{
+    {
+        std::lock_guard<std::mutex> lk(m_round_mutex);
+        m_quit = true;
+    }
+    m_round_start.notify_all();
+
+    for (auto &t : m_threads)
+        t.join();
+}
+//---------------------------------------------------------------------------
+
+void GCParallelMarker::thread_main(size_t idx)
+{
+    size_t round = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lk(m_round_mutex);
+            m_round_start.wait(
+                lk, [this, round]() { return m_quit || m_round != round; });
+            if (m_quit)
+                return;
+            round = m_round;
+        }
+
+        work(idx);
+
+        {
+            std::lock_guard<std::mutex> lk(m_round_mutex);
+            m_num_done++;
+        }
+        m_round_done.notify_one();
+    }
+}
+//---------------------------------------------------------------------------
+
+bool GCParallelMarker::mark(
+    uint8_t color,
+    uint64_t *side_marks,
+    std::vector<AtomVec *> &vecs,
+    std::vector<AtomMap *> &maps,
+    std::vector<UserData *> &userdata)
+{
+    m_color      = color;
+    m_side_marks = side_marks;
+    m_found_free = false;
+
+    // The initial objects are distributed over the shared deques,
+    // they are not marked yet:
+    size_t n = m_workers.size();
+    size_t i = 0;
+    for (auto vec : vecs)
+    {
+        if (vec && gc_par_try_mark(vec, color, side_marks))
+        {
+            Worker &w = *m_workers[i++ % n];
+            w.m_shared_vecs.push_back(vec);
+            w.m_num_shared++;
+        }
+    }
+    for (auto map : maps)
+    {
+        if (map && gc_par_try_mark(map, color, side_marks))
+        {
+            Worker &w = *m_workers[i++ % n];
+            w.m_shared_maps.push_back(map);
+            w.m_num_shared++;
+        }
+    }
+    vecs.clear();
+    maps.clear();
+
+    m_num_active = n;
+    {
+        std::lock_guard<std::mutex> lk(m_round_mutex);
+        m_num_done = 0;
+        m_round++;
+    }
+    m_round_start.notify_all();
+
+    work(0);
+
+    {
+        std::unique_lock<std::mutex> lk(m_round_mutex);
+        m_round_done.wait(
+            lk, [this, n]() { return m_num_done == n - 1; });
+    }
+
+    for (auto &w : m_workers)
+    {
+        userdata.insert(
+            userdata.end(), w->m_userdata.begin(), w->m_userdata.end());
+        w->m_userdata.clear();
+    }
+
+    return !m_found_free;
+}
+//---------------------------------------------------------------------------
+
+void GCParallelMarker::push_vec(Worker &w, AtomVec *vec)
+{
+    if (!vec) return;
+    if (gc_par_get_color(&vec->m_gc_color) == GC_COLOR_FREE)
+    {
+        m_found_free = true;
+        return;
+    }
+    if (gc_par_try_mark(vec, m_color, m_side_marks))
+        w.m_vecs.push_back(vec);
+}
+//---------------------------------------------------------------------------
+
+void GCParallelMarker::push_map(Worker &w, AtomMap *map)
+{
+    if (!map) return;
+    if (gc_par_get_color(&map->m_gc_color) == GC_COLOR_FREE)
+    {
+        m_found_free = true;
+        return;
+    }
+    if (gc_par_try_mark(map, m_color, m_side_marks))
+        w.m_maps.push_back(map);
+}
+//---------------------------------------------------------------------------
+
+void GCParallelMarker::push_atom(Worker &w, const Atom &a)
+{
+    switch (a.m_type)
+    {
+        case T_MAP:
+            push_map(w, a.m_d.map);
+            break;
+
+        case T_CLOS:
+        case T_VEC:
+            push_vec(w, a.m_d.vec);
+            break;
+
+        case T_UD:
+            if (a.m_d.ud && gc_par_try_mark(a.m_d.ud, m_color, m_side_marks))
+                w.m_userdata.push_back(a.m_d.ud);
+            break;
+
+        case T_SYNTAX:
+        case T_KW:
+        case T_SYM:
+        case T_STR:
+            if (   a.m_d.sym
+                && gc_par_get_color(&a.m_d.sym->m_gc_color) != GC_COLOR_FROZEN)
+                gc_par_set_color(&a.m_d.sym->m_gc_color, m_color);
+            break;
+
+        default:
+            break;
+    }
+}
+//---------------------------------------------------------------------------
+
+void GCParallelMarker::scan_vec(Worker &w, AtomVec *vec)
+{
+    for (size_t i = 0; i < vec->m_len; i++)
+    {
+        push_atom(w, vec->m_data[i]);
+
+        if ((i % GC_PAR_SCAN_CHUNK) == (GC_PAR_SCAN_CHUNK - 1))
+            share(w);
+    }
+
+    push_vec(w, vec->m_meta);
+}
+//---------------------------------------------------------------------------
+
+void GCParallelMarker::scan_map(Worker &w, AtomMap *map)
+{
+    ATOM_MAP_FOR(i, map)
+    {
+        push_atom(w, MAP_ITER_KEY(i));
+        push_atom(w, MAP_ITER_VAL(i));
+    }
+
+    push_vec(w, map->m_meta);
+}
+//---------------------------------------------------------------------------
+
+void GCParallelMarker::share(Worker &w)
+{
+    if (   w.m_num_shared > 0
+        || (w.m_vecs.size() + w.m_maps.size()) < GC_PAR_SHARE_MIN)
+        return;
+
+    std::lock_guard<std::mutex> lk(w.m_shared_mutex);
+
+    size_t nv = w.m_vecs.size() / 2;
+    w.m_shared_vecs.insert(
+        w.m_shared_vecs.end(), w.m_vecs.begin(), w.m_vecs.begin() + nv);
+    w.m_vecs.erase(w.m_vecs.begin(), w.m_vecs.begin() + nv);
+
+    size_t nm = w.m_maps.size() / 2;
+    w.m_shared_maps.insert(
+        w.m_shared_maps.end(), w.m_maps.begin(), w.m_maps.begin() + nm);
+    w.m_maps.erase(w.m_maps.begin(), w.m_maps.begin() + nm);
+
+    w.m_num_shared += nv + nm;
+}
+//---------------------------------------------------------------------------
+
+// Moves half of the shared deque of victim to the private stacks of thief.
+bool GCParallelMarker::take_shared(Worker &thief, Worker &victim)
+{
+    if (victim.m_num_shared == 0)
+        return false;
+
+    std::lock_guard<std::mutex> lk(victim.m_shared_mutex);
+
+    size_t nv = (victim.m_shared_vecs.size() + 1) / 2;
+    for (size_t i = 0; i < nv; i++)
+    {
+        thief.m_vecs.push_back(victim.m_shared_vecs.front());
+        victim.m_shared_vecs.pop_front();
+    }
+
+    size_t nm = (victim.m_shared_maps.size() + 1) / 2;
+    for (size_t i = 0; i < nm; i++)
+    {
+        thief.m_maps.push_back(victim.m_shared_maps.front());
+        victim.m_shared_maps.pop_front();
+    }
+
+    victim.m_num_shared -= nv + nm;
+    return (nv + nm) > 0;
+}
+//---------------------------------------------------------------------------
+
+bool GCParallelMarker::steal(size_t idx)
+{
+    Worker &w = *m_workers[idx];
+    size_t n = m_workers.size();
+
+    for (size_t i = 1; i < n; i++)
+    {
+        if (take_shared(w, *m_workers[(idx + i) % n]))
+            return true;
+    }
+
+    return false;
+}
+//---------------------------------------------------------------------------
+
+bool GCParallelMarker::any_shared()
+{
+    for (auto &w : m_workers)
+        if (w->m_num_shared > 0)
+            return true;
+    return false;
+}
+//---------------------------------------------------------------------------
+
+void GCParallelMarker::work(size_t idx)
+{
+    Worker &w = *m_workers[idx];
+
+    for (;;)
+    {
+        while (!(w.m_vecs.empty() && w.m_maps.empty()))
+        {
+            if (!w.m_vecs.empty())
+            {
+                AtomVec *vec = w.m_vecs.back();
+                w.m_vecs.pop_back();
+                scan_vec(w, vec);
+            }
+            else
+            {
+                AtomMap *map = w.m_maps.back();
+                w.m_maps.pop_back();
+                scan_map(w, map);
+            }
+
+            share(w);
+        }
+
+        if (take_shared(w, w) || steal(idx))
+            continue;
+
+        // We ran out of work. The marking is done when all threads
+        // are out of work, as only working threads can share new work.
+        m_num_active--;
+        for (;;)
+        {
+            if (m_num_active == 0)
+                return;
+
+            if (any_shared())
+            {
+                m_num_active++;
+                if (take_shared(w, w) || steal(idx))
+                    break;
+                m_num_active--;
+            }
+
+            std::this_thread::yield();
+        }
+    }
+}
+//---------------------------------------------------------------------------
+
+}
+
+/******************************************************************************
+* Copyright (C) 2017 Weird Constructor
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
@@ -0,0 +1,132 @@
+// Copyright (C) 2017 Weird Constructor
+// For more license info refer to the the bottom of this file.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+namespace bukalisp
+{
+//---------------------------------------------------------------------------
+
+struct AtomVec;
+struct Atom;
+class  UserData;
+class  AtomHash;
+
+template<typename Atom, typename HashFunc>
+struct HashTable;
+
+typedef HashTable<Atom, AtomHash> AtomMap;
+//---------------------------------------------------------------------------
+
+/* Marks vectors and maps of a full collection on several threads.
+ *
+ * Every thread has a private mark stack and a shared deque. When its
+ * private stack grows, a thread moves half of it to its shared deque,
+ * where idle threads can steal it. Objects are marked by an atomic
+ * compare and swap of m_gc_color, so every object is scanned only once.
+ * Frozen objects (see GC::freeze()) are marked by setting their bit in
+ * the side bitmap atomically.
+ *
+ * Userdata is not marked by the worker threads, because its mark()
+ * method calls back into the GC. It is returned to the caller, which
+ * marks it and calls mark() again with the objects it found.
+ */
+class GCParallelMarker
+{
+    private:
+        struct Worker
+        {
+            std::vector<AtomVec *>   m_vecs;
+            std::vector<AtomMap *>   m_maps;
+            std::vector<UserData *>  m_userdata;
+
+            std::mutex               m_shared_mutex;
+            std::deque<AtomVec *>    m_shared_vecs;
+            std::deque<AtomMap *>    m_shared_maps;
+            std::atomic<size_t>      m_num_shared;
+
+            Worker() : m_num_shared(0) { }
+        };
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::vector<std::thread>             m_threads;
+
+        std::mutex               m_round_mutex;
+        std::condition_variable  m_round_start;
+        std::condition_variable  m_round_done;
+        size_t                   m_round;
+        size_t                   m_num_done;
+        bool                     m_quit;
+
+        std::atomic<size_t>      m_num_active;
+        std::atomic<bool>        m_found_free;
+        uint8_t                  m_color;
+        uint64_t                *m_side_marks;
+
+        void thread_main(size_t idx);
+        void work(size_t idx);
+
+        void push_atom(Worker &w, const Atom &a);
+        void push_vec(Worker &w, AtomVec *vec);
+        void push_map(Worker &w, AtomMap *map);
+        void scan_vec(Worker &w, AtomVec *vec);
+        void scan_map(Worker &w, AtomMap *map);
+
+        void share(Worker &w);
+        bool take_shared(Worker &thief, Worker &victim);
+        bool steal(size_t idx);
+        bool any_shared();
+
+    public:
+        GCParallelMarker(size_t num_threads);
+        ~GCParallelMarker();
+
+        size_t num_threads() const { return m_workers.size(); }
+
+        // Marks everything that is reachable from vecs and maps with
+        // color, or in side_marks for frozen objects. The calling thread
+        // takes part in the marking. Both
+        // vectors are emptied. Newly marked userdata is appended to
+        // userdata. Returns false if a free object was encountered,
+        // which indicates a rooting bug.
+        bool mark(uint8_t color,
+                  uint64_t *side_marks,
+                  std::vector<AtomVec *> &vecs,
+                  std::vector<AtomMap *> &maps,
+                  std::vector<UserData *> &userdata);
+};
+//---------------------------------------------------------------------------
+
+}
+
+/******************************************************************************
+* Copyright (C) 2017 Weird Constructor
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
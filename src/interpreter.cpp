@@ -7,6 +7,7 @@
 #include <chrono>
 #include "util.h"
 #include "atom_cpp_serializer.h"
+#include "prog_image.h"
 
 using namespace std;
 
@@ -928,7 +929,7 @@ Atom Interpreter::call_compiler(
     try
     {
         AtomVec *args = m_rt->m_gc.allocate_vector(5);
-        args->push(Atom(T_STR, m_rt->m_gc.new_symbol(input_name)));
+        args->push(Atom(T_STR, m_rt->m_gc.new_string(input_name)));
         args->push(prog);
         args->push(Atom(T_MAP, root_env));
         args->push(Atom(T_BOOL, only_compile));
@@ -113,6 +113,10 @@ class MemoryPool
         SegmentGroup    m_big;
         SegmentGroup    m_huge;
 
+        // Bytes of the blocks that are currently handed out,
+        // the GC uses this to decide when to collect:
+        size_t          m_bytes_in_use;
+
     public:
         MemoryPool()
 //            : m_tiny(10,   2),
@@ -126,7 +130,8 @@ class MemoryPool
               m_medium(50, 100),
               m_large(50, 500),
               m_big(10,  1500),
-              m_huge(10, 4000)
+              m_huge(10, 4000),
+              m_bytes_in_use(0)
 //            : m_tiny(1000,   2),
 //              m_small(1000, 10),
 //              m_medium(300, 100),
@@ -148,6 +153,8 @@ class MemoryPool
             return ss.str();
         }
 
+        size_t bytes_in_use() const { return m_bytes_in_use; }
+
         Type *allocate(size_t block_len)
         {
             // XXX TESTING:
@@ -155,7 +162,16 @@ class MemoryPool
             return new Type[block_len];
 #endif
 
+            Type *mem = allocate_block(block_len);
+            Descriptor *d =
+                (Descriptor *) (((char *) mem) - sizeof(Descriptor));
+            m_bytes_in_use += d->size * sizeof(Type);
+            return mem;
+        }
 
+    private:
+        Type *allocate_block(size_t block_len)
+        {
 //            std::lock_guard<std::mutex> lock(m_global_lock);
             size_t type_block_byte_len = sizeof(Type) * block_len;
             size_t block_byte_len      = sizeof(Descriptor) + type_block_byte_len;
@@ -195,6 +211,7 @@ class MemoryPool
             return new (buf + sizeof(Descriptor)) Type[block_len];
         }
 
+    public:
         void free(Type *mem)
         {
 #if TEST_DISABLE_MEM_POOL_INTERNAL
@@ -204,6 +221,7 @@ class MemoryPool
 //            std::lock_guard<std::mutex> lock(m_global_lock);
             Descriptor *d =
                 (Descriptor *) (((char *) mem) - sizeof(Descriptor));
+            m_bytes_in_use -= d->size * sizeof(Type);
 
             if (d->size == m_tiny.m_block_size)
             {
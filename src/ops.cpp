@@ -7,16 +7,17 @@ switch (m_pc->op)
 {
 //---------------------------------------------------------------------------
 
-case OP_STACK_TRC:
+VM_OP(STACK_TRC)
 {
     E_SET_CHECK_REALLOC(O, O);
-    Atom tmp = dump_stack_trace(m_rt->m_gc, cont_stack, m_prog, m_pc);
+    Atom tmp =
+        dump_stack_trace(m_rt->m_gc, cont_stack, cont_base, m_prog, m_pc);
     E_SET(O, tmp);
     break;
 }
 
 //---------------------------------------------------------------------------
-case OP_DUMP_ENV_STACK:
+VM_OP(DUMP_ENV_STACK)
 {
 // TODO: Check
 //                    for (size_t i = 0; i < frm_stack->m_len; i++)
@@ -31,16 +32,30 @@ case OP_DUMP_ENV_STACK:
 }
 //---------------------------------------------------------------------------
 
-case OP_MOV:
+VM_OP(MOV)
 {
     E_SET_CHECK_REALLOC(O, O);
     E_GET(tmp, A);
     E_SET(O, *tmp);
     break;
 }
+
+#define     DEFINE_MOV_SPEC(ro, ra)                \
+VM_OP(MOV_##ro##ra)                                 \
+{                                                   \
+    *E_PTR_##ro(O) = *E_PTR_##ra(A);                \
+    break;                                          \
+}
+
+DEFINE_MOV_SPEC(F, F)
+DEFINE_MOV_SPEC(F, D)
+DEFINE_MOV_SPEC(F, R)
+DEFINE_MOV_SPEC(R, F)
+DEFINE_MOV_SPEC(R, D)
+DEFINE_MOV_SPEC(R, R)
 //---------------------------------------------------------------------------
 
-case OP_NEW_ARG_VEC:
+VM_OP(NEW_ARG_VEC)
 {
     E_SET_CHECK_REALLOC(O, O);
     alloc = true;
@@ -60,7 +75,7 @@ case OP_NEW_ARG_VEC:
 }
 //---------------------------------------------------------------------------
 
-case OP_NEW_VEC:
+VM_OP(NEW_VEC)
 {
     E_SET_CHECK_REALLOC(O, O);
     alloc = true;
@@ -69,7 +84,7 @@ case OP_NEW_VEC:
 }
 //---------------------------------------------------------------------------
 
-case OP_NEW_MAP:
+VM_OP(NEW_MAP)
 {
     E_SET_CHECK_REALLOC(O, O);
     alloc = true;
@@ -99,7 +114,7 @@ case OP_NEW_MAP:
 }
 //---------------------------------------------------------------------------
 
-case OP_CSET_VEC:
+VM_OP(CSET_VEC)
 {
     Atom *vec;
     E_GET(vec, O);
@@ -131,7 +146,7 @@ case OP_CSET_VEC:
 }
 //---------------------------------------------------------------------------
 
-case OP_SET:
+VM_OP(SET)
 {
     E_GET(tmp, O);
     Atom &vec = *tmp;
@@ -161,7 +176,7 @@ case OP_SET:
 }
 //---------------------------------------------------------------------------
 
-case OP_GET:
+VM_OP(GET)
 {
     E_SET_CHECK_REALLOC(O, O);
 
@@ -184,9 +199,23 @@ case OP_GET:
 
     break;
 }
+
+VM_OP(GET_FFD)
+{
+    Atom *vec = E_PTR_F(A);
+    Atom *key = E_PTR_D(B);
+
+    if (vec->m_type == T_MAP)
+        *E_PTR_F(O) = vec->m_d.map->at(*key);
+    else if (vec->m_type == T_VEC)
+        *E_PTR_F(O) = vec->m_d.vec->at((size_t) key->to_int());
+    else
+        error("Can GET on vector and map", *vec);
+    break;
+}
 //---------------------------------------------------------------------------
 
-case OP_LOAD_NIL:
+VM_OP(LOAD_NIL)
 {
     E_SET_CHECK_REALLOC(O, O);
     E_SET(O, Atom());
@@ -194,7 +223,7 @@ case OP_LOAD_NIL:
 }
 //---------------------------------------------------------------------------
 
-case OP_NEW_CLOSURE:
+VM_OP(NEW_CLOSURE)
 {
     E_SET_CHECK_REALLOC(O, O);
 
@@ -246,7 +275,7 @@ case OP_NEW_CLOSURE:
 }
 //---------------------------------------------------------------------------
 
-case OP_NEW_UPV:
+VM_OP(NEW_UPV)
 {
     E_SET_CHECK_REALLOC(A, A);
     E_SET_CHECK_REALLOC(O, O);
@@ -265,8 +294,14 @@ case OP_NEW_UPV:
 }
 //---------------------------------------------------------------------------
 
-case OP_CALL:
+VM_OP(TAILCALL)
+    tail_call = true;
+    // fall through to CALL
+VM_OP(CALL)
 {
+    bool is_tail_call = tail_call;
+    tail_call = false;
+
     E_SET_CHECK_REALLOC(O, O);
 
     Atom *func;
@@ -275,13 +310,21 @@ case OP_CALL:
     E_GET(argv_tmp, B);
     if (argv_tmp->m_type != T_VEC)
         error("Bad argument index vector!", *argv_tmp);
-    AtomVec *av    = argv_tmp->m_d.vec;
-    AtomVec *frame = nullptr;
+    AtomVec *av      = argv_tmp->m_d.vec;
+    AtomVec *frame   = nullptr;
+    bool     own_row = false;
 
     if (PE_B == REG_ROW_DATA)
     {
         size_t len = av->m_len;
-        frame = m_rt->m_gc.allocate_vector(len);
+        if (func->m_type == T_CLOS)
+        {
+            // The register row of the callee is recycled on return:
+            frame   = cont_stack->take_row(m_rt->m_gc, len);
+            own_row = true;
+        }
+        else
+            frame = m_rt->m_gc.allocate_vector(len);
         frame->m_len = len >> 1;
         for (size_t i = 0, j = 0; i < av->m_len; i += 2, j++)
         {
@@ -306,7 +349,8 @@ case OP_CALL:
             try
             {
                 (*func->m_d.func)(*(frame), *ot);
-                if (m_trace) cout << "CALL=> " << ot->to_write_str() << endl;
+                E_WRITE_BARRIER_D(PE_O, P_O);
+                if (VM_TRACE) cout << "CALL=> " << ot->to_write_str() << endl;
             }
             catch (VMRaise &r)
             {
@@ -321,7 +365,7 @@ case OP_CALL:
             catch (BukaLISPException &e)
             {
                 std::cout << "EX0" << e.what() << std::endl;
-                if (m_trace) cout << "CALL=>Exception!" << endl;
+                if (VM_TRACE) cout << "CALL=>Exception!" << endl;
                 e.set_do_ctrl_jmp();
                 throw e;
             }
@@ -336,11 +380,58 @@ case OP_CALL:
 
             alloc = true;
 
-            Atom &arity = func->m_d.vec->m_data[VM_CLOS_ARITY];
+            // A tail call takes over the call frame of the current
+            // function, if nothing else (cleanups, jumps) is on top of it.
+            // Coroutine frames are left alone for GET_CORO and YIELD,
+            // and so are frames of another root env for EVAL.
+            VMFrame *call_frame = nullptr;
+            if (is_tail_call
+                && func->m_d.vec->m_data[VM_CLOS_IS_CORO].is_false())
+            {
+                VMFrame *c = CONT_STACK_LAST();
+                if (   c
+                    && c->m_len == VM_CALL_FRAME_SIZE
+                    && c->m_data[VM_CF_CLOS].m_type == T_CLOS
+                    && c->m_data[VM_CF_CLOS].m_d.vec->m_data[VM_CLOS_IS_CORO].is_false()
+                    && c->m_data[VM_CF_ROOT].m_d.vec == root_env)
+                {
+                    call_frame = c;
+                    call_frame->m_data[VM_CF_CLOS] = *func;
+                    func = &(call_frame->m_data[VM_CF_CLOS]);
+
+                    // The register row of the current function is not
+                    // needed anymore. If it was created by a CALL, it is
+                    // reused for the arguments. Otherwise the rows of a
+                    // loop would reference each other through the
+                    // argument vector registers and stay alive.
+                    if (   c->m_data[VM_CF_PROG].m_type == T_UD
+                        && rr_frame != frame)
+                    {
+                        size_t argc = frame->m_len;
+                        rr_frame->m_len = 0;
+                        if (argc > 0)
+                            rr_frame->check_size(argc - 1);
+                        for (size_t i = 0; i < argc; i++)
+                            rr_frame->m_data[i] = frame->m_data[i];
+
+                        if (own_row)
+                            cont_stack->give_back_row(frame);
+                        frame   = rr_frame;
+                        own_row = call_frame->m_own_row;
+                    }
+                    else if (call_frame->m_own_row && rr_frame != frame)
+                        cont_stack->give_back_row(rr_frame);
+                }
+            }
 
             // save the current execution context:
-            RECORD_CALL_FRAME(*func, call_frame);
-            cont_stack->push(call_frame);
+            if (!call_frame)
+            {
+                RECORD_CALL_FRAME(*func, new_call_frame);
+                call_frame = new_call_frame;
+            }
+
+            Atom &arity = func->m_d.vec->m_data[VM_CLOS_ARITY];
 
             if (func->m_d.vec->m_data[VM_CLOS_IS_CORO].m_type == T_VEC)
             {
@@ -358,6 +449,8 @@ case OP_CALL:
                           Atom(T_INT, frame->m_len));
 
                 Atom ret_val = frame->at(0);
+                if (own_row)
+                    cont_stack->give_back_row(frame);
 
                 AtomVec *coro_cont_stack =
                     func->m_d.vec->m_data[VM_CLOS_IS_CORO].m_d.vec;
@@ -368,10 +461,13 @@ case OP_CALL:
                 for (size_t i = coro_cont_stack->m_len; i > 0; i--)
                     cont_stack->push(coro_cont_stack->m_data[i - 1]);
 
-                RESTORE_FROM_CALL_FRAME(restore_frame, ret_val);
+                RESTORE_FROM_CALL_FRAME(
+                    restore_frame.m_d.vec->m_data, ret_val);
             }
             else
             {
+                call_frame->m_own_row = own_row;
+
                 if (CHECK_ARITY(arity, frame->m_len) != 0)
                     report_arity_error(arity, frame->m_len);
 
@@ -402,6 +498,7 @@ case OP_CALL:
                 }
 
                 m_prog   = dynamic_cast<PROG*>(func->m_d.vec->m_data[VM_CLOS_PROG].m_d.ud);
+                VM_THREAD_PROG(m_prog);
                 m_pc     = &(m_prog->m_instructions[0]);
                 m_pc--;
 
@@ -418,6 +515,7 @@ case OP_CALL:
                 }
                 SET_FRAME_ROW(frame);
                 SET_ROOT_ENV(m_prog->m_root_regs);
+                PREPARE_PROG_ROWS(m_prog);
             }
             break;
         }
@@ -429,7 +527,7 @@ case OP_CALL:
 }
 //---------------------------------------------------------------------------
 
-case OP_EVAL:
+VM_OP(EVAL)
 {
     E_SET_CHECK_REALLOC(O, O);
 
@@ -456,9 +554,9 @@ case OP_EVAL:
         // using a special root environment, which is completely
         // uninteresting to the actual user of (eval ...).
         AtomVec *caller_env = nullptr;
-        for (size_t i = cont_stack->m_len; i > 0; i--)
+        for (size_t i = cont_stack->m_len; i > cont_base; i--)
         {
-            AtomVec *frame = cont_stack->m_data[i - 1].m_d.vec;
+            VMFrame *frame = cont_stack->at(i - 1);
             if (frame->m_len == VM_CALL_FRAME_SIZE)
             {
                 caller_env = frame->m_data[VM_CF_ROOT].m_d.vec;
@@ -494,8 +592,7 @@ case OP_EVAL:
     // XXX: We should record some kind of fake-closure here for
     //      debugging purposes. or some kind of other marker, so
     //      we can generate sensible stacktraces.
-    call_frame.m_d.vec->set(VM_CF_CLOS, prog);
-    cont_stack->push(call_frame);
+    call_frame->m_data[VM_CF_CLOS] = prog;
 
 //                    atom_tree_walker(call_frame, [](std::function<void(Atom &a)> con, unsigned int indent, Atom a)
 //                    {
@@ -506,6 +603,7 @@ case OP_EVAL:
 //                    });
 
     m_prog   = dynamic_cast<PROG*>(prog.m_d.ud);
+    VM_THREAD_PROG(m_prog);
     m_pc     = &(m_prog->m_instructions[0]);
     m_pc--;
 //                    std::cout << "PUT PROG: " << ((void *) m_pc) << ";" << ((void *) m_prog) << std::endl;
@@ -514,16 +612,17 @@ case OP_EVAL:
     AtomVec *eval_frame = m_rt->m_gc.allocate_vector(0);
     SET_FRAME_ROW(eval_frame);
     Atom cf_root_env =
-        eval_env->at(Atom(T_STR, m_rt->m_gc.new_symbol(" REGS ")));
+        eval_env->at(Atom(T_STR, m_rt->m_gc.new_string(" REGS ")));
     if (cf_root_env.m_type != T_VEC)
         error("Bad environment with 'eval', no [\" REGS \"] given",
               cf_root_env);
     SET_ROOT_ENV(cf_root_env.m_d.vec);
+    PREPARE_PROG_ROWS(m_prog);
     break;
 }
 //---------------------------------------------------------------------------
 
-case OP_RETURN:
+VM_OP(RETURN)
 {
 
     // We get the returnvalue here, so we don't get corrupt
@@ -535,16 +634,14 @@ case OP_RETURN:
 
     // retrieve the continuation and skip non-call-frames:
     bool exec_cleanup = false;
-    Atom *c = cont_stack->last();
-    while (   c
-           && c->m_type == T_VEC
-           && c->m_d.vec->m_len != VM_CALL_FRAME_SIZE)
+    VMFrame *c = CONT_STACK_LAST();
+    while (c && c->m_len != VM_CALL_FRAME_SIZE)
     {
-        if (c->m_d.vec->m_len == VM_CLNUP_FRAME_SIZE)
+        if (c->m_len == VM_CLNUP_FRAME_SIZE)
         {
             JUMP_TO_CLEANUP(
                 exec_cleanup,
-                c->m_d.vec,
+                c,
                 Atom(T_INT, VM_CLNUP_COND_RETURN),
                 Atom(),
                 ret_val);
@@ -552,41 +649,42 @@ case OP_RETURN:
         }
 
         cont_stack->pop();
-        c = cont_stack->last();
+        c = CONT_STACK_LAST();
     }
 
     if (exec_cleanup)
         break;
 
-    if (!c || c->m_type == T_NIL)
+    if (!c)
     {
         ret = ret_val;
         m_pc = &(m_prog->m_instructions[m_prog->m_instructions_len - 2]);
         break;
     }
 
-    Atom call_frame = *c;
+    // The frame stays in the memory of the cont_stack after
+    // the pop(), nothing is pushed before it is restored:
+    bool     own_row    = c->m_own_row;
+    AtomVec *callee_row = rr_frame;
     cont_stack->pop();
-    if (call_frame.m_type != T_VEC || call_frame.m_d.vec->m_len < VM_CALL_FRAME_SIZE)
-        error("Empty or bad call frame stack item!", call_frame);
 
-    RESTORE_FROM_CALL_FRAME(call_frame, ret_val);
+    RESTORE_FROM_CALL_FRAME(c->m_data, ret_val);
+    if (own_row)
+        cont_stack->give_back_row(callee_row);
     break;
 }
 //---------------------------------------------------------------------------
 
-case OP_GET_CORO:
+VM_OP(GET_CORO)
 {
     Atom func;
-    size_t ret_cont_stack_idx = 0;
-    for (size_t i = cont_stack->m_len; i > 0; i--)
+    for (size_t i = cont_stack->m_len; i > cont_base; i--)
     {
-        Atom &frm = cont_stack->m_data[i - 1];
-        if (   frm.m_type == T_VEC
-            && frm.m_d.vec->m_len == VM_CALL_FRAME_SIZE
-            && !frm.at(VM_CF_CLOS).at(VM_CLOS_IS_CORO).is_false())
+        VMFrame *frm = cont_stack->at(i - 1);
+        if (   frm->m_len == VM_CALL_FRAME_SIZE
+            && !frm->m_data[VM_CF_CLOS].at(VM_CLOS_IS_CORO).is_false())
         {
-            func = frm.at(VM_CF_CLOS);
+            func = frm->m_data[VM_CF_CLOS];
             break;
         }
     }
@@ -597,29 +695,30 @@ case OP_GET_CORO:
 }
 //---------------------------------------------------------------------------
 
-case OP_YIELD:
+VM_OP(YIELD)
 {
     E_GET(tmp, A);
     Atom ret_val = *tmp;
 
-    Atom *c = nullptr;
-    for (size_t i = cont_stack->m_len; i > 0; i--)
+    VMFrame *c = nullptr;
+    for (size_t i = cont_stack->m_len; i > cont_base; i--)
     {
-        c = &(cont_stack->m_data[i - 1]);
-        if (   c->m_type == T_VEC
-            && c->m_d.vec->m_len == VM_CALL_FRAME_SIZE)
-        {
+        c = cont_stack->at(i - 1);
+        if (c->m_len == VM_CALL_FRAME_SIZE)
             break;
-        }
         c = nullptr;
     }
 
-    if (!c || c->m_type == T_NIL)
+    if (!c)
         error("Can't yield from direct top level. "
               "VM/Compiler ERROR!?!?!", *tmp);
 
-    Atom cur_func = c->at(0);
-    RECORD_CALL_FRAME(cur_func, coro_cont_frame);
+    // The frames that the coroutine takes along are promoted
+    // to the heap:
+    Atom cur_func = c->m_data[VM_CF_CLOS];
+    RECORD_CALL_FRAME(cur_func, coro_cont_frame_stk);
+    Atom coro_cont_frame = coro_cont_frame_stk->to_atom(m_rt->m_gc);
+    cont_stack->pop();
 
     AtomVec *cont_copy =
         m_rt->m_gc.allocate_vector(cont_stack->m_len);
@@ -642,24 +741,25 @@ case OP_YIELD:
     //    the coroutine.
     // 4. return from the T_CLOS call as "usual" with the value
     //    passed into YIELD as 'A'.
-    Atom ret_call_frame;
+    VMFrame *ret_call_frame = nullptr;
     Atom func;
     size_t ret_cont_stack_idx = 0;
-    for (size_t i = cont_stack->m_len; i > 0; i--)
+    for (size_t i = cont_stack->m_len; i > cont_base; i--)
     {
-        Atom &frm = cont_stack->m_data[i - 1];
-        //d// cout << "FRM: " << frm.m_type << " F: " << frm.at(0).at(2).to_write_str() << endl;
-        if (!frm.at(VM_CF_CLOS).at(VM_CLOS_IS_CORO).is_false())
+        VMFrame *frm = cont_stack->at(i - 1);
+        if (   frm->m_len == VM_CALL_FRAME_SIZE
+            && !frm->m_data[VM_CF_CLOS].at(VM_CLOS_IS_CORO).is_false())
         {
             //d// cout << "FOUND COROUTINE CALL AT DEPTH="
             //d//      << i << " of " << cont_stack->m_len << endl;
             ret_call_frame = frm;
-            func           = frm.at(VM_CF_CLOS);
+            func           = frm->m_data[VM_CF_CLOS];
             ret_cont_stack_idx = i - 1;
             break;
         }
 
-        cont_copy->set((cont_stack->m_len - i), frm);
+        cont_copy->set(
+            (cont_stack->m_len - i), frm->to_atom(m_rt->m_gc));
     }
 
     if (func.m_type == T_CLOS)
@@ -676,17 +776,14 @@ case OP_YIELD:
               ret_val);
 
     cont_stack->m_len = ret_cont_stack_idx;
-    RESTORE_FROM_CALL_FRAME(ret_call_frame, ret_val);
+    RESTORE_FROM_CALL_FRAME(ret_call_frame->m_data, ret_val);
     break;
 }
 //---------------------------------------------------------------------------
 
-case OP_PUSH_JMP:
+VM_OP(PUSH_JMP)
 {
-    AtomVec *jmp_frame =
-        m_rt->m_gc.allocate_vector(
-            VM_JUMP_FRAME_SIZE);
-    jmp_frame->m_len = VM_JUMP_FRAME_SIZE;
+    VMFrame *jmp_frame = cont_stack->push(VM_JUMP_FRAME_SIZE);
     jmp_frame->m_data[VM_JMP_PC].set_ptr(m_pc + P_A);
     if (P_B < 0)
         jmp_frame->m_data[VM_JMP_TAG].clear();
@@ -697,56 +794,47 @@ case OP_PUSH_JMP:
     }
     jmp_frame->m_data[VM_JMP_OUT_I].set_int(P_O);
     jmp_frame->m_data[VM_JMP_OUT_E].set_int(PE_O);
-    cont_stack->push(Atom(T_VEC, jmp_frame));
     break;
 }
 //---------------------------------------------------------------------------
 
-case OP_POP_JMP:
+VM_OP(POP_JMP)
 {
-    Atom *c = cont_stack->last();
-    if (   !c
-        || c->m_type != T_VEC
-        || c->m_d.vec->m_len != VM_JUMP_FRAME_SIZE)
+    VMFrame *c = CONT_STACK_LAST();
+    if (!c || c->m_len != VM_JUMP_FRAME_SIZE)
         error("Bad ctrl jmp frame on stack",
-              c ? *c : Atom());
+              c ? c->to_atom(m_rt->m_gc) : Atom());
 
     cont_stack->pop();
     break;
 }
 //---------------------------------------------------------------------------
 
-case OP_PUSH_CLNUP:
+VM_OP(PUSH_CLNUP)
 {
-    AtomVec *clnup_frame =
-        m_rt->m_gc.allocate_vector(
-            VM_CLNUP_FRAME_SIZE);
-    clnup_frame->m_len = VM_CLNUP_FRAME_SIZE;
+    VMFrame *clnup_frame = cont_stack->push(VM_CLNUP_FRAME_SIZE);
     clnup_frame->m_data[VM_CLNUP_PC].set_ptr(m_pc + P_A);
     clnup_frame->m_data[VM_CLNUP_COND_I].set_int(P_O);
     clnup_frame->m_data[VM_CLNUP_COND_E].set_int(PE_O);
     clnup_frame->m_data[VM_CLNUP_VAL_I].set_int(P_B);
     clnup_frame->m_data[VM_CLNUP_VAL_E].set_int(PE_B);
-    cont_stack->push(Atom(T_VEC, clnup_frame));
     break;
 }
 //---------------------------------------------------------------------------
 
-case OP_POP_CLNUP:
+VM_OP(POP_CLNUP)
 {
-    Atom *c = cont_stack->last();
-    if (   !c
-        || c->m_type != T_VEC
-        || c->m_d.vec->m_len != VM_CLNUP_FRAME_SIZE)
+    VMFrame *c = CONT_STACK_LAST();
+    if (!c || c->m_len != VM_CLNUP_FRAME_SIZE)
         error("Bad cleanup frame on stack",
-              c ? *c : Atom());
+              c ? c->to_atom(m_rt->m_gc) : Atom());
 
     cont_stack->pop();
     break;
 }
 //---------------------------------------------------------------------------
 
-case OP_CTRL_JMP:
+VM_OP(CTRL_JMP)
 {
     Atom raised_val;
     if (PE_O == REG_ROW_SPECIAL)
@@ -769,24 +857,21 @@ case OP_CTRL_JMP:
     //d// std::cout << "****** CTRL JMP TAG@ " << jmp_tag.to_write_str() << std::endl;
 
     bool exec_cleanup = false;
-    Atom *c = cont_stack->last();
-    while (c && (   c->m_type != T_VEC
-                 || c->m_d.vec->m_len != VM_JUMP_FRAME_SIZE
-                 || (   c->m_d.vec->m_len == VM_JUMP_FRAME_SIZE
-                     && !(c->m_d.vec->m_data[VM_JMP_TAG] == jmp_tag))))
+    VMFrame *c = CONT_STACK_LAST();
+    while (c && (   c->m_len != VM_JUMP_FRAME_SIZE
+                 || !(c->m_data[VM_JMP_TAG] == jmp_tag)))
     {
-        if (c->m_d.vec->m_len == VM_CALL_FRAME_SIZE)
+        if (c->m_len == VM_CALL_FRAME_SIZE)
         {
             // Restore earlier call frames (return from routines)
-            Atom call_frame = *c;
             Atom nil_val;
-            RESTORE_FROM_CALL_FRAME(call_frame, nil_val);
+            RESTORE_FROM_CALL_FRAME(c->m_data, nil_val);
         }
-        else if (c->m_d.vec->m_len == VM_CLNUP_FRAME_SIZE)
+        else if (c->m_len == VM_CLNUP_FRAME_SIZE)
         {
             JUMP_TO_CLEANUP(
                 exec_cleanup,
-                c->m_d.vec,
+                c,
                 Atom(T_INT, VM_CLNUP_COND_CTRL_JMP),
                 jmp_tag,
                 raised_val);
@@ -794,7 +879,7 @@ case OP_CTRL_JMP:
         }
 
         cont_stack->pop();
-        c = cont_stack->last();
+        c = CONT_STACK_LAST();
     }
 
     if (exec_cleanup)
@@ -804,37 +889,35 @@ case OP_CTRL_JMP:
     // happen actually. Either we end up in a cleanup
     // frame or the exception is caught here in a proper
     // jmp_frame!
-    if (   !c
-        || c->m_type == T_NIL
-        || (   c->m_type != T_VEC
-            && c->m_d.vec->m_len != VM_JUMP_FRAME_SIZE))
+    if (!c || c->m_len != VM_JUMP_FRAME_SIZE)
         throw VMRaise(m_rt->m_gc, raised_val);
 
-    AtomVec *jmp_frame = c->m_d.vec;
-    if (   jmp_frame->at(VM_JMP_PC).m_type    != T_C_PTR
-        || !(jmp_frame->at(VM_JMP_TAG)        == jmp_tag)
-        || jmp_frame->at(VM_JMP_OUT_I).m_type != T_INT
-        || jmp_frame->at(VM_JMP_OUT_E).m_type != T_INT)
-        error("Bad exception handler/jump block frame on call stack", *c);
+    VMFrame jmp_frame = *c;
+    if (   jmp_frame.m_data[VM_JMP_PC].m_type    != T_C_PTR
+        || !(jmp_frame.m_data[VM_JMP_TAG]        == jmp_tag)
+        || jmp_frame.m_data[VM_JMP_OUT_I].m_type != T_INT
+        || jmp_frame.m_data[VM_JMP_OUT_E].m_type != T_INT)
+        error("Bad exception handler/jump block frame on call stack",
+              c->to_atom(m_rt->m_gc));
 
     cont_stack->pop();
 
     E_SET_CHECK_REALLOC_D(
-        jmp_frame->at(VM_JMP_OUT_E).m_d.i,
-        jmp_frame->at(VM_JMP_OUT_I).m_d.i);
+        jmp_frame.m_data[VM_JMP_OUT_E].m_d.i,
+        jmp_frame.m_data[VM_JMP_OUT_I].m_d.i);
     E_SET_D(
-        jmp_frame->at(VM_JMP_OUT_E).m_d.i,
-        jmp_frame->at(VM_JMP_OUT_I).m_d.i,
+        jmp_frame.m_data[VM_JMP_OUT_E].m_d.i,
+        jmp_frame.m_data[VM_JMP_OUT_I].m_d.i,
         raised_val);
 
-    m_pc = (INST *) jmp_frame->at(VM_JMP_PC).m_d.ptr;
+    m_pc = (INST *) jmp_frame.m_data[VM_JMP_PC].m_d.ptr;
     if (m_pc >= (m_prog->m_instructions + m_prog->m_instructions_len))
         error("CTRL_JMP out of PROG", Atom());
     break;
 }
 //---------------------------------------------------------------------------
 
-case OP_BR:
+VM_OP(BR)
 {
     m_pc += P_O;
     if (m_pc >= (m_prog->m_instructions + m_prog->m_instructions_len))
@@ -843,33 +926,94 @@ case OP_BR:
 }
 //---------------------------------------------------------------------------
 
-case OP_BRIF:
+#define     BRIF_BODY(cond_ptr, neg)                                     \
+    if (neg (cond_ptr)->is_false())                                  \
+    {                                                                \
+        m_pc += P_O;                                                 \
+        if (m_pc >= (m_prog->m_instructions + m_prog->m_instructions_len)) \
+            error("BRIF out of PROG", Atom());                       \
+    }
+
+VM_OP(BRIF)
 {
     E_GET(tmp, A);
-    if (!tmp->is_false())
-    {
-        m_pc += P_O;
-        if (m_pc >= (m_prog->m_instructions + m_prog->m_instructions_len))
-            error("BRIF out of PROG", Atom());
-    }
+    BRIF_BODY(tmp, !);
+    break;
+}
+
+VM_OP(BRIF_F)
+{
+    BRIF_BODY(E_PTR_F(A), !);
     break;
 }
 //---------------------------------------------------------------------------
 
-case OP_BRNIF:
+VM_OP(BRNIF)
 {
     E_GET(tmp, A);
-    if (tmp->is_false())
-    {
-        m_pc += P_O;
-        if (m_pc >= (m_prog->m_instructions + m_prog->m_instructions_len))
-            error("BRIF out of PROG", Atom());
-    }
+    BRIF_BODY(tmp, );
+    break;
+}
+
+VM_OP(BRNIF_F)
+{
+    BRIF_BODY(E_PTR_F(A), );
     break;
 }
 //---------------------------------------------------------------------------
 
-case OP_FORINC:
+#define     FORINC_BODY(cond_ptr, step_ptr, end_ptr, iter_ptr) { \
+    Atom *fi_cond   = (cond_ptr);                                \
+    Atom *fi_step   = (step_ptr);                                \
+    Atom *fi_end    = (end_ptr);                                 \
+    Atom *fi_iter   = (iter_ptr);                                \
+    bool  fi_update = fi_cond->m_type == T_BOOL;                 \
+                                                                 \
+    switch (fi_iter->m_type)                                     \
+    {                                                            \
+        case T_INT:                                              \
+        {                                                        \
+            int64_t step_i = fi_step->m_d.i;                     \
+            int64_t i = fi_iter->m_d.i;                          \
+            if (fi_update) i += step_i;                          \
+            fi_cond->m_type = T_BOOL;                            \
+            fi_cond->m_d.b =                                     \
+                step_i > 0                                       \
+                ? i > fi_end->m_d.i                              \
+                : i < fi_end->m_d.i;                             \
+            fi_iter->m_d.i = i;                                  \
+            break;                                               \
+        }                                                        \
+        case T_DBL:                                              \
+        {                                                        \
+            double step_i = fi_step->m_d.d;                      \
+            double i = fi_iter->m_d.d;                           \
+            if (fi_update) i += step_i;                          \
+            fi_cond->m_type = T_BOOL;                            \
+            fi_cond->m_d.b =                                     \
+                step_i > 0.0                                     \
+                ? i > fi_end->m_d.d                              \
+                : i < fi_end->m_d.d;                             \
+            fi_iter->m_d.d = i;                                  \
+            break;                                               \
+        }                                                        \
+        default:                                                 \
+        {                                                        \
+            int64_t step_i = fi_step->to_int();                  \
+            int64_t i = fi_iter->m_d.i;                          \
+            if (fi_update) i += step_i;                          \
+            fi_cond->m_type = T_BOOL;                            \
+            fi_cond->m_d.b =                                     \
+                step_i > 0                                       \
+                ? i > fi_end->to_int()                           \
+                : i < fi_end->to_int();                          \
+            fi_iter->m_d.i = i;                                  \
+            break;                                               \
+        }                                                        \
+    }                                                            \
+}
+
+VM_OP(FORINC)
 {
     E_SET_CHECK_REALLOC(O, O);
 
@@ -883,55 +1027,43 @@ case OP_FORINC:
     Atom *condt;
     E_SET_D_PTR(PE_O, P_O, condt);
 
-    bool update = condt->m_type == T_BOOL;
-
-    switch (ot->m_type)
-    {
-        case T_INT:
-        {
-            int64_t step_i = step->m_d.i;
-            int64_t i = ot->m_d.i;
-            if (update) i += step_i;
-            condt->m_type = T_BOOL;
-            condt->m_d.b =
-                step_i > 0
-                ? i > tmp->m_d.i
-                : i < tmp->m_d.i;
-            ot->m_d.i = i;
-            break;
-        }
-        case T_DBL:
-        {
-            double step_i = step->m_d.d;
-            double i = ot->m_d.d;
-            if (update) i += step_i;
-            condt->m_type = T_BOOL;
-            condt->m_d.b =
-                step_i > 0.0
-                ? i > tmp->m_d.d
-                : i < tmp->m_d.d;
-            ot->m_d.d = i;
-            break;
-        }
-        default:
-        {
-            int64_t step_i = step->to_int();
-            int64_t i = ot->m_d.i;
-            if (update) i += step_i;
-            condt->m_type = T_BOOL;
-            condt->m_d.b =
-                step_i > 0
-                ? i > tmp->to_int()
-                : i < tmp->to_int();
-            ot->m_d.i = i;
-            break;
-        }
-    }
+    FORINC_BODY(condt, step, tmp, ot);
     break;
 }
+
+#define     DEFINE_FORINC_SPEC(ra, rb)               \
+VM_OP(FORINC_F##ra##rb##F)                            \
+{                                                     \
+    FORINC_BODY(E_PTR_F(O), E_PTR_##ra(A),            \
+                E_PTR_##rb(B), E_PTR_F(C));           \
+    break;                                            \
+}
+
+DEFINE_FORINC_SPEC(F, F)
+DEFINE_FORINC_SPEC(F, D)
+DEFINE_FORINC_SPEC(D, F)
+DEFINE_FORINC_SPEC(D, D)
+
+// Fused with the BRNIF_F on the condition, that follows:
+#define     DEFINE_FORINC_BRNIF(ra, rb)              \
+VM_OP(FORINC_F##ra##rb##F_BRNIF)                      \
+{                                                     \
+    Atom *cond = E_PTR_F(O);                          \
+    FORINC_BODY(cond, E_PTR_##ra(A),                  \
+                E_PTR_##rb(B), E_PTR_F(C));           \
+    m_pc++;                                           \
+    BRIF_BODY(cond, );                                \
+    break;                                            \
+}
+
+DEFINE_FORINC_BRNIF(F, F)
+DEFINE_FORINC_BRNIF(F, D)
+DEFINE_FORINC_BRNIF(D, F)
+DEFINE_FORINC_BRNIF(D, D)
 //---------------------------------------------------------------------------
 
-case OP_NOT:
+
+VM_OP(NOT)
 {
     E_SET_CHECK_REALLOC(O, O);
 
@@ -943,7 +1075,7 @@ case OP_NOT:
 }
 //---------------------------------------------------------------------------
 
-case OP_ISNIL:
+VM_OP(ISNIL)
 {
     E_SET_CHECK_REALLOC(O, O);
 
@@ -955,7 +1087,7 @@ case OP_ISNIL:
 }
 //---------------------------------------------------------------------------
 
-case OP_EQV:
+VM_OP(EQV)
 {
     E_SET_CHECK_REALLOC(O, O);
 
@@ -971,7 +1103,7 @@ case OP_EQV:
 }
 //---------------------------------------------------------------------------
 
-case OP_EQ:
+VM_OP(EQ)
 {
     E_SET_CHECK_REALLOC(O, O);
 
@@ -991,7 +1123,7 @@ case OP_EQ:
 }
 //---------------------------------------------------------------------------
 
-case OP_NEQ:
+VM_OP(NEQ)
 {
     E_SET_CHECK_REALLOC(O, O);
 
@@ -1011,7 +1143,7 @@ case OP_NEQ:
 }
 //---------------------------------------------------------------------------
 
-case OP_ITER:
+VM_OP(ITER)
 {
     E_SET_CHECK_REALLOC(O, O);
 
@@ -1041,7 +1173,7 @@ case OP_ITER:
 }
 //---------------------------------------------------------------------------
 
-case OP_NEXT:
+VM_OP(NEXT)
 {
     E_SET_CHECK_REALLOC(O, O);
     E_SET_CHECK_REALLOC(A, A);
@@ -1082,7 +1214,7 @@ case OP_NEXT:
 }
 //---------------------------------------------------------------------------
 
-case OP_IKEY:
+VM_OP(IKEY)
 {
     E_SET_CHECK_REALLOC(O, O);
     E_GET(tmp, A);
@@ -1108,8 +1240,16 @@ case OP_IKEY:
 }
 //---------------------------------------------------------------------------
 
+#define     NUM_OP_BOOL_BODY(o, a, b, oper)                   \
+    if ((a)->m_type == T_DBL || (b)->m_type == T_DBL)         \
+        (o).m_d.b = (a)->to_dbl() oper (b)->to_dbl();         \
+    else if ((a)->m_type == T_INT)                            \
+        (o).m_d.b = (a)->m_d.i    oper (b)->to_int();         \
+    else                                                      \
+        (o).m_d.b = (a)->to_int() oper (b)->to_int();
+
 #define     DEFINE_NUM_OP_BOOL(opname, oper)              \
-case OP_##opname:                                         \
+VM_OP(opname)                                             \
 {                                                         \
     E_SET_CHECK_REALLOC(O, O);                            \
     Atom *a, *b;                                          \
@@ -1117,68 +1257,160 @@ case OP_##opname:                                         \
     E_GET(b, B);                                          \
                                                           \
     Atom o(T_BOOL);                                       \
-    if (a->m_type == T_DBL || b->m_type == T_DBL)         \
-        o.m_d.b = a->m_d.d    oper b->to_dbl();           \
-    else if (a->m_type == T_INT)                          \
-        o.m_d.b = a->m_d.i    oper b->to_int();           \
-    else                                                  \
-        o.m_d.b = a->to_int() oper b->to_int();           \
+    NUM_OP_BOOL_BODY(o, a, b, oper);                      \
     E_SET(O, o);                                          \
     break;                                                \
 }
 
-#define     DEFINE_NUM_OP_NUM(opname, oper, neutr)                   \
-case OP_##opname:                                                    \
-{                                                                    \
-    E_SET_CHECK_REALLOC(O, O);                                       \
-    Atom *a, *b;                                                     \
-    E_GET(a, A);                                                     \
-    E_GET(b, B);                                                     \
-                                                                     \
-    Atom *ot;                                                        \
-    E_SET_D_PTR(PE_O, P_O, ot);                                      \
-    if (a->m_type == T_DBL)                                          \
+#define     DEFINE_NUM_OP_BOOL_SPEC(opname, ra, rb, oper) \
+VM_OP(opname##_F##ra##rb)                                 \
+{                                                         \
+    Atom *a = E_PTR_##ra(A);                              \
+    Atom *b = E_PTR_##rb(B);                              \
+    VM_QUICKEN(OP_##opname##_F##ra##rb,                   \
+               a->m_type, b->m_type);                     \
+    Atom o(T_BOOL);                                       \
+    NUM_OP_BOOL_BODY(o, a, b, oper);                      \
+    *E_PTR_F(O) = o;                                      \
+    break;                                                \
+}
+
+// Quickened variant for two operands of type qt, that are
+// compared as their m_d.fld. Other types undo the quickening.
+#define     DEFINE_NUM_OP_BOOL_QUICK(opname, ra, rb, oper, q, qt, fld) \
+VM_OP(opname##_F##ra##rb##_##q)                           \
+{                                                         \
+    Atom *a = E_PTR_##ra(A);                              \
+    Atom *b = E_PTR_##rb(B);                              \
+    Atom o(T_BOOL);                                       \
+    if (a->m_type == qt && b->m_type == qt)               \
+        o.m_d.b = a->m_d.fld oper b->m_d.fld;             \
+    else                                                  \
+    {                                                     \
+        VM_REWRITE_OP(OP_##opname##_F##ra##rb);           \
+        NUM_OP_BOOL_BODY(o, a, b, oper);                  \
+    }                                                     \
+    *E_PTR_F(O) = o;                                      \
+    break;                                                \
+}
+
+#define     DEFINE_NUM_OP_BOOL_SPEC_ALL(opname, ra, rb, oper)             \
+    DEFINE_NUM_OP_BOOL_SPEC(opname, ra, rb, oper)                         \
+    DEFINE_NUM_OP_BOOL_QUICK(opname, ra, rb, oper, II, T_INT, i)          \
+    DEFINE_NUM_OP_BOOL_QUICK(opname, ra, rb, oper, DD, T_DBL, d)
+
+#define     DEFINE_NUM_OP_BOOL_SPECS(opname, oper)        \
+    DEFINE_NUM_OP_BOOL_SPEC_ALL(opname, F, F, oper)       \
+    DEFINE_NUM_OP_BOOL_SPEC_ALL(opname, F, D, oper)       \
+    DEFINE_NUM_OP_BOOL_SPEC_ALL(opname, R, F, oper)       \
+    DEFINE_NUM_OP_BOOL_SPEC_ALL(opname, R, D, oper)
+
+#define     NUM_OP_NUM_BODY(ot, a, b, oper, neutr)                   \
+    if ((a)->m_type == T_DBL)                                        \
     {                                                                \
-        ot->m_d.d = a->m_d.d    oper b->to_dbl();                    \
-        ot->m_type = T_DBL;                                          \
+        (ot)->m_d.d = (a)->m_d.d    oper (b)->to_dbl();              \
+        (ot)->m_type = T_DBL;                                        \
     }                                                                \
-    else if (b->m_type == T_DBL)                                     \
+    else if ((b)->m_type == T_DBL)                                   \
     {                                                                \
-        ot->m_d.d = a->to_dbl() oper b->m_d.d;                       \
-        ot->m_type = T_DBL;                                          \
+        (ot)->m_d.d = (a)->to_dbl() oper (b)->m_d.d;                 \
+        (ot)->m_type = T_DBL;                                        \
     }                                                                \
-    else if (a->m_type == T_INT)                                     \
+    else if ((a)->m_type == T_INT)                                   \
     {                                                                \
-        ot->m_d.i = a->m_d.i    oper b->to_int();                    \
-        ot->m_type = T_INT;                                          \
+        (ot)->m_d.i = (a)->m_d.i    oper (b)->to_int();              \
+        (ot)->m_type = T_INT;                                        \
     }                                                                \
-    else if (a->m_type == T_NIL)                                     \
+    else if ((a)->m_type == T_NIL)                                   \
     {                                                                \
-        if (b->m_type == T_INT)                                      \
+        if ((b)->m_type == T_INT)                                    \
         {                                                            \
-            ot->m_d.i = ((int64_t) neutr) oper b->m_d.i;             \
-            ot->m_type = T_INT;                                      \
+            (ot)->m_d.i = ((int64_t) neutr) oper (b)->m_d.i;         \
+            (ot)->m_type = T_INT;                                    \
         }                                                            \
         else                                                         \
         {                                                            \
-            ot->m_d.d = ((double) neutr) oper b->to_dbl();           \
-            ot->m_type = T_DBL;                                      \
+            (ot)->m_d.d = ((double) neutr) oper (b)->to_dbl();       \
+            (ot)->m_type = T_DBL;                                    \
         }                                                            \
     }                                                                \
     else                                                             \
     {                                                                \
-        ot->m_d.i = a->to_int() oper b->to_int();                    \
-        ot->m_type = T_INT;                                          \
+        (ot)->m_d.i = (a)->to_int() oper (b)->to_int();              \
+        (ot)->m_type = T_INT;                                        \
+    }
+
+#define     DEFINE_NUM_OP_NUM(opname, oper, neutr)                   \
+VM_OP(opname)                                                        \
+{                                                                    \
+    E_SET_CHECK_REALLOC(O, O);                                       \
+    Atom *a, *b;                                                     \
+    E_GET(a, A);                                                     \
+    E_GET(b, B);                                                     \
+                                                                     \
+    Atom *ot;                                                        \
+    E_SET_D_PTR(PE_O, P_O, ot);                                      \
+    NUM_OP_NUM_BODY(ot, a, b, oper, neutr);                          \
+    break;                                                           \
+}
+
+#define     DEFINE_NUM_OP_NUM_SPEC(opname, ro, ra, rb, oper, neutr)  \
+VM_OP(opname##_##ro##ra##rb)                                         \
+{                                                                    \
+    Atom *a  = E_PTR_##ra(A);                                        \
+    Atom *b  = E_PTR_##rb(B);                                        \
+    Atom *ot = E_PTR_##ro(O);                                        \
+    VM_QUICKEN(OP_##opname##_##ro##ra##rb, a->m_type, b->m_type);    \
+    NUM_OP_NUM_BODY(ot, a, b, oper, neutr);                          \
+    break;                                                           \
+}
+
+// Quickened variant for two operands of type qt, see
+// DEFINE_NUM_OP_BOOL_QUICK.
+#define     DEFINE_NUM_OP_NUM_QUICK(opname, ro, ra, rb, oper, neutr, q, qt, fld) \
+VM_OP(opname##_##ro##ra##rb##_##q)                                   \
+{                                                                    \
+    Atom *a  = E_PTR_##ra(A);                                        \
+    Atom *b  = E_PTR_##rb(B);                                        \
+    Atom *ot = E_PTR_##ro(O);                                        \
+    if (a->m_type == qt && b->m_type == qt)                          \
+    {                                                                \
+        ot->m_d.fld  = a->m_d.fld oper b->m_d.fld;                   \
+        ot->m_type   = qt;                                           \
+    }                                                                \
+    else                                                             \
+    {                                                                \
+        VM_REWRITE_OP(OP_##opname##_##ro##ra##rb);                   \
+        NUM_OP_NUM_BODY(ot, a, b, oper, neutr);                      \
     }                                                                \
     break;                                                           \
 }
 
+#define     DEFINE_NUM_OP_NUM_SPEC_ALL(opname, ro, ra, rb, oper, neutr)          \
+    DEFINE_NUM_OP_NUM_SPEC(opname, ro, ra, rb, oper, neutr)                      \
+    DEFINE_NUM_OP_NUM_QUICK(opname, ro, ra, rb, oper, neutr, II, T_INT, i)       \
+    DEFINE_NUM_OP_NUM_QUICK(opname, ro, ra, rb, oper, neutr, DD, T_DBL, d)
+
+#define     DEFINE_NUM_OP_NUM_SPECS(opname, oper, neutr)             \
+    DEFINE_NUM_OP_NUM_SPEC_ALL(opname, F, F, F, oper, neutr)         \
+    DEFINE_NUM_OP_NUM_SPEC_ALL(opname, F, F, D, oper, neutr)         \
+    DEFINE_NUM_OP_NUM_SPEC_ALL(opname, F, R, F, oper, neutr)         \
+    DEFINE_NUM_OP_NUM_SPEC_ALL(opname, F, R, D, oper, neutr)         \
+    DEFINE_NUM_OP_NUM_SPEC_ALL(opname, R, F, F, oper, neutr)         \
+    DEFINE_NUM_OP_NUM_SPEC_ALL(opname, R, F, D, oper, neutr)         \
+    DEFINE_NUM_OP_NUM_SPEC_ALL(opname, R, R, F, oper, neutr)         \
+    DEFINE_NUM_OP_NUM_SPEC_ALL(opname, R, R, D, oper, neutr)
+
 DEFINE_NUM_OP_NUM(ADD, +, 0)
 DEFINE_NUM_OP_NUM(SUB, -, 0)
 DEFINE_NUM_OP_NUM(MUL, *, 1)
 DEFINE_NUM_OP_NUM(DIV, /, 1)
 
-case OP_MOD:
+DEFINE_NUM_OP_NUM_SPECS(ADD, +, 0)
+DEFINE_NUM_OP_NUM_SPECS(SUB, -, 0)
+DEFINE_NUM_OP_NUM_SPECS(MUL, *, 1)
+
+VM_OP(MOD)
 {
     E_SET_CHECK_REALLOC(O, O);
 
@@ -1205,13 +1437,54 @@ DEFINE_NUM_OP_BOOL(LE, <=)
 DEFINE_NUM_OP_BOOL(LT, <)
 DEFINE_NUM_OP_BOOL(GT, >)
 
+DEFINE_NUM_OP_BOOL_SPECS(GE, >=)
+DEFINE_NUM_OP_BOOL_SPECS(LE, <=)
+DEFINE_NUM_OP_BOOL_SPECS(LT, <)
+DEFINE_NUM_OP_BOOL_SPECS(GT, >)
+
+// Comparison fused with the BRIF_F (neg = !) or BRNIF_F on its
+// result, that follows. Two integers are compared right away,
+// like the quickened _II variants do.
+#define     DEFINE_NUM_OP_BOOL_BR(opname, rb, oper, br, neg)  \
+VM_OP(opname##_FF##rb##_##br)                             \
+{                                                         \
+    Atom *a = E_PTR_F(A);                                 \
+    Atom *b = E_PTR_##rb(B);                              \
+    Atom o(T_BOOL);                                       \
+    if (a->m_type == T_INT && b->m_type == T_INT)         \
+        o.m_d.b = a->m_d.i oper b->m_d.i;                 \
+    else                                                  \
+    {                                                     \
+        NUM_OP_BOOL_BODY(o, a, b, oper);                  \
+    }                                                     \
+    *E_PTR_F(O) = o;                                      \
+    m_pc++;                                               \
+    BRIF_BODY(&o, neg);                                   \
+    break;                                                \
+}
+
+#define     DEFINE_NUM_OP_BOOL_BRS(opname, oper)                  \
+    DEFINE_NUM_OP_BOOL_BR(opname, F, oper, BRIF,  !)              \
+    DEFINE_NUM_OP_BOOL_BR(opname, D, oper, BRIF,  !)              \
+    DEFINE_NUM_OP_BOOL_BR(opname, F, oper, BRNIF,  )              \
+    DEFINE_NUM_OP_BOOL_BR(opname, D, oper, BRNIF,  )
+
+DEFINE_NUM_OP_BOOL_BRS(GE, >=)
+DEFINE_NUM_OP_BOOL_BRS(LE, <=)
+DEFINE_NUM_OP_BOOL_BRS(LT, <)
+DEFINE_NUM_OP_BOOL_BRS(GT, >)
+
 //---------------------------------------------------------------------------
 
-case OP_NOP:
+VM_OP(NOP)
     break;
 //---------------------------------------------------------------------------
 
-default:
+// Not implemented by this VM:
+VM_OP(LOAD_PRIM)
+VM_OP(MOV_FROM)
+VM_OP(MOV_TO)
+VM_OP_DEFAULT
     throw BukaLISPException("Unknown VM opcode: " + to_string(m_pc->op));
 }
 m_pc++;
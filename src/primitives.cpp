@@ -124,12 +124,12 @@ START_PRIM()
         error("'number->string' too many arguments");
     if (args.m_len == 1)
     {
-        out = Atom(T_STR, m_rt->m_gc.new_symbol(A0.to_write_str()));
+        out = Atom(T_STR, m_rt->m_gc.new_string(A0.to_write_str()));
     }
     else
     {
         if (A0.m_type == T_DBL)
-            out = Atom(T_STR, m_rt->m_gc.new_symbol(A0.to_write_str()));
+            out = Atom(T_STR, m_rt->m_gc.new_string(A0.to_write_str()));
         else
         {
             int base  = (int) A1.to_int();
@@ -149,7 +149,7 @@ START_PRIM()
             } while(dv.quot);
             if (i < 0) buf += "-";
             std::string out_buf(buf.rbegin(), buf.rend());
-            out = Atom(T_STR, m_rt->m_gc.new_symbol(out_buf));
+            out = Atom(T_STR, m_rt->m_gc.new_string(out_buf));
         }
     }
 END_PRIM(number->string)
@@ -241,7 +241,7 @@ START_PRIM()
     REQ_EQ_ARGC(string-downcase, 1)
     std::string in = A0.to_display_str();
     std::transform(in.begin(), in.end(), in.begin(), ::tolower);
-    out = Atom(T_STR, m_rt->m_gc.new_symbol(in));
+    out = Atom(T_STR, m_rt->m_gc.new_string(in));
 END_PRIM_DOC(string-downcase,
 "@strings procedure (string-downcase _value_)\n"
 "\n"
@@ -251,7 +251,7 @@ START_PRIM()
     REQ_EQ_ARGC(string-upcase, 1)
     std::string in = A0.to_display_str();
     std::transform(in.begin(), in.end(), in.begin(), ::toupper);
-    out = Atom(T_STR, m_rt->m_gc.new_symbol(in));
+    out = Atom(T_STR, m_rt->m_gc.new_string(in));
 END_PRIM_DOC(string-upcase,
 "@strings procedure (string-upcase _value_)\n"
 "\n"
@@ -268,7 +268,7 @@ START_PRIM()
 		: std::string::npos;
 	if (start < s.size())
 		s = s.substr(start, len);
-	out = Atom(T_STR, m_rt->m_gc.new_symbol(s));
+	out = Atom(T_STR, m_rt->m_gc.new_string(s));
 END_PRIM_DOC(substring,
 "@strings procedure (substring _string_ _start_)\n"
 "@strings procedure (substring _string_ _start_ _end_)\n"
@@ -626,9 +626,70 @@ END_PRIM(bkl-make-vm-prog)
 
 START_PRIM()
     REQ_EQ_ARGC(bkl-prog-serialize, 2);
-    out = Atom(T_STR, m_rt->m_gc.new_symbol(atom2cpp(A0.to_display_str(), A1)));
+    out = Atom(T_STR, m_rt->m_gc.new_string(atom2cpp(A0.to_display_str(), A1)));
 END_PRIM(bkl-prog-serialize)
 
+START_PRIM()
+    REQ_GT_ARGC(bkl-save-prog-image, 2);
+    REQ_S_ARG(A0,
+        "'bkl-save-prog-image' requires a string, symbol "
+        "or keyword as first argument.");
+    uint32_t flags = 0;
+    if (args.m_len > 2 && !A2.is_false())
+        flags |= BKL_PROG_IMAGE_SNAPSHOT;
+    out = Atom(T_BOOL,
+               save_prog_image_file(m_rt->m_gc, A0.m_d.sym->m_str, A1, flags));
+END_PRIM_DOC(bkl-save-prog-image,
+"@internal procedure (bkl-save-prog-image _file-path_ _value_ [_snapshot?_])\n"
+"\n"
+"Writes _value_ as binary .bklc image to _file-path_. _value_ may\n"
+"contain compiled BKL-VM-PROGs, closures, lists, maps and any printable\n"
+"atom. Primitives and other user data can't be written.\n"
+"If _snapshot?_ is true, the instructions are written as the VM\n"
+"specialized them. Such an image loads faster, but only into a build\n"
+"with the same opcodes.\n"
+"Returns true if the file was written successfully.\n"
+"\n"
+"    (bkl-save-prog-image \"x.bklc\" (compile '(+ 1 2)))\n"
+)
+
+START_PRIM()
+    REQ_EQ_ARGC(bkl-load-prog-image, 1);
+    REQ_S_ARG(A0,
+        "'bkl-load-prog-image' requires a string, symbol "
+        "or keyword as first argument.");
+    out = load_prog_image_file(m_rt->m_gc, A0.m_d.sym->m_str);
+END_PRIM_DOC(bkl-load-prog-image,
+"@internal procedure (bkl-load-prog-image _file-path_)\n"
+"\n"
+"Loads the binary .bklc image at _file-path_, that was written by\n"
+"`bkl-save-prog-image`, without invoking the compiler.\n"
+"The file is mapped into memory for reading, if the platform supports it.\n"
+"\n"
+"    (bkl-run-vm (bkl-load-prog-image \"x.bklc\"))\n"
+)
+
+START_PRIM()
+    REQ_EQ_ARGC(bkl-disassemble, 1);
+    Atom prog = A0;
+    if (prog.m_type == T_CLOS && prog.m_d.vec->m_len > VM_CLOS_PROG)
+        prog = prog.m_d.vec->m_data[VM_CLOS_PROG];
+    if (prog.m_type != T_UD || prog.m_d.ud->type() != "BKL-VM-PROG")
+        error("'bkl-disassemble' requires a BKL-VM-PROG or a closure", A0);
+    out = Atom(T_STR, m_rt->m_gc.new_string(
+            static_cast<PROG*>(prog.m_d.ud)->disassemble()));
+END_PRIM_DOC(bkl-disassemble,
+"@internal procedure (bkl-disassemble _prog-or-closure_)\n"
+"\n"
+"Returns a listing of the VM instructions of the compiled\n"
+"_prog-or-closure_ as string. The listing shows the operand\n"
+"specialized opcodes the PROG runs with, the frame and root\n"
+"register row sizes they rely on and the number of fused\n"
+"superinstructions.\n"
+"\n"
+"    (display (bkl-disassemble (lambda (x) (+ x 1))))\n"
+)
+
 START_PRIM()
     REQ_GT_ARGC(bkl-run-vm, 1);
 
@@ -735,7 +796,7 @@ START_PRIM()
     std::string out_str;
     for (size_t i = 0; i < args.m_len; i++)
         out_str += args.m_data[i].to_display_str();
-    out = Atom(T_STR, m_rt->m_gc.new_symbol(out_str));
+    out = Atom(T_STR, m_rt->m_gc.new_string(out_str));
 END_PRIM(str)
 
 START_PRIM()
@@ -748,7 +809,7 @@ START_PRIM()
             out_str += sep;
         out_str += args.m_data[i].to_display_str();
     }
-    out = Atom(T_STR, m_rt->m_gc.new_symbol(out_str));
+    out = Atom(T_STR, m_rt->m_gc.new_string(out_str));
 END_PRIM(str-join)
 
 START_PRIM()
@@ -769,14 +830,14 @@ START_PRIM()
     REQ_EQ_ARGC(string->symbol, 1)
     if (A0.m_type != T_STR)
         error("'string->symbol' expected string as argument", A0);
-    out = Atom(T_SYM, A0.m_d.sym);
+    out = Atom(T_SYM, m_rt->m_gc.new_symbol(A0.m_d.sym->m_str));
 END_PRIM(string->symbol)
 
 START_PRIM()
     REQ_EQ_ARGC(string->keyword, 1)
     if (A0.m_type != T_STR)
         error("'string->keyword' expected string as argument", A0);
-    out = Atom(T_KW, A0.m_d.sym);
+    out = Atom(T_KW, m_rt->m_gc.new_symbol(A0.m_d.sym->m_str));
 END_PRIM(string->keyword)
 
 START_PRIM()
@@ -872,12 +933,12 @@ END_PRIM(reverse)
 
 START_PRIM()
     REQ_EQ_ARGC(write-str, 1);
-    out = Atom(T_STR, m_rt->m_gc.new_symbol(A0.to_write_str()));
+    out = Atom(T_STR, m_rt->m_gc.new_string(A0.to_write_str()));
 END_PRIM(write-str);
 
 START_PRIM()
     REQ_EQ_ARGC(pp-str, 1);
-    out = Atom(T_STR, m_rt->m_gc.new_symbol(A0.to_write_str(true)));
+    out = Atom(T_STR, m_rt->m_gc.new_string(A0.to_write_str(true)));
 END_PRIM(pp-str);
 
 START_PRIM()
@@ -919,7 +980,9 @@ START_PRIM()
     REQ_S_ARG(A0,
         "'bkl-slurp-file' requires a string, symbol "
         "or keyword as first argument.");
-    out = Atom(T_STR, m_rt->m_gc.new_symbol(slurp_str(A0.m_d.sym->m_str)));
+    if (m_rt->m_log_file_reads)
+        m_rt->m_file_read_log.push_back(A0.m_d.sym->m_str);
+    out = Atom(T_STR, m_rt->m_gc.new_string(slurp_str(A0.m_d.sym->m_str)));
 END_PRIM(sys-slurp-file)
 
 START_PRIM()
@@ -932,7 +995,7 @@ END_PRIM(sys-write-file)
 
 START_PRIM()
     REQ_EQ_ARGC(sys-path-separator, 0);
-    out = Atom(T_STR, m_rt->m_gc.new_symbol(BKL_PATH_SEP));
+    out = Atom(T_STR, m_rt->m_gc.new_string(BKL_PATH_SEP));
 END_PRIM(sys-path-separator)
 
 START_PRIM()
@@ -942,20 +1005,20 @@ START_PRIM()
     AtomVec *av = m_rt->m_gc.allocate_vector(2);
     if (pos == string::npos)
     {
-        av->push(Atom(T_STR, m_rt->m_gc.new_symbol(s)));
-        av->push(Atom(T_STR, m_rt->m_gc.new_symbol("")));
+        av->push(Atom(T_STR, m_rt->m_gc.new_string(s)));
+        av->push(Atom(T_STR, m_rt->m_gc.new_string("")));
     }
     else
     {
-        av->push(Atom(T_STR, m_rt->m_gc.new_symbol(s.substr(0, pos))));
-        av->push(Atom(T_STR, m_rt->m_gc.new_symbol(s.substr(pos + 1))));
+        av->push(Atom(T_STR, m_rt->m_gc.new_string(s.substr(0, pos))));
+        av->push(Atom(T_STR, m_rt->m_gc.new_string(s.substr(pos + 1))));
     }
     out = Atom(T_VEC, av);
 END_PRIM(sys-path-split)
 
 START_PRIM()
     REQ_EQ_ARGC(sys-platform, 0);
-    out = Atom(T_STR, m_rt->m_gc.new_symbol(BKL_PLATFORM));
+    out = Atom(T_STR, m_rt->m_gc.new_string(BKL_PLATFORM));
 END_PRIM(sys-platform)
 
 START_PRIM()
@@ -1039,6 +1102,119 @@ END_PRIM_DOC(bkl-gc-statistics,
 "in a map.\n"
 )
 
+START_PRIM()
+    REQ_EQ_ARGC(bkl-gc-freeze, 0);
+    m_rt->m_gc.freeze();
+    out = Atom(T_INT, (int64_t) m_rt->m_gc.num_frozen_objects());
+END_PRIM_DOC(bkl-gc-freeze,
+"@internal procedure (bkl-gc-freeze)\n"
+"\n"
+"Performs a garbage collection and makes all objects that are still\n"
+"alive permanent. They are never freed, and later collections do not\n"
+"write to them, so they stay shared with processes that are forked\n"
+"afterwards (see `bklisp --fork-server`). Returns the number of\n"
+"frozen objects.\n"
+)
+
+START_PRIM()
+    if (args.m_len > 0)
+    {
+        if (A0.m_type != T_INT || A0.m_d.i < 0)
+            error("bkl-gc-pause-budget expects a positive integer", A0);
+        out = Atom(T_INT, (int64_t) m_rt->m_gc.get_pause_budget_us());
+        m_rt->m_gc.set_pause_budget_us((size_t) A0.m_d.i);
+    }
+    else
+        out = Atom(T_INT, (int64_t) m_rt->m_gc.get_pause_budget_us());
+END_PRIM_DOC(bkl-gc-pause-budget,
+"@internal procedure (bkl-gc-pause-budget [_microseconds_])\n"
+"\n"
+"Returns the maximum time one incremental marking step of the\n"
+"garbage collector may take. If _microseconds_ is given, it\n"
+"sets a new budget and returns the old one. A budget of 0 makes the\n"
+"garbage collector do major collections at once.\n"
+)
+
+START_PRIM()
+    if (args.m_len > 0)
+    {
+        if (A0.m_type != T_INT || A0.m_d.i < 1)
+            error("bkl-gc-mark-threads expects an integer >= 1", A0);
+        out = Atom(T_INT, (int64_t) m_rt->m_gc.get_mark_threads());
+        m_rt->m_gc.set_mark_threads((size_t) A0.m_d.i);
+    }
+    else
+        out = Atom(T_INT, (int64_t) m_rt->m_gc.get_mark_threads());
+END_PRIM_DOC(bkl-gc-mark-threads,
+"@internal procedure (bkl-gc-mark-threads [_count_])\n"
+"\n"
+"Returns the number of threads, that mark the objects of a major\n"
+"garbage collection. If _count_ is given, it sets a new number and\n"
+"returns the old one. With more than one thread, major collections\n"
+"do not use the pause budget of `bkl-gc-pause-budget`.\n"
+)
+
+START_PRIM()
+    if (args.m_len > 0)
+    {
+        if (   !(A0.m_type == T_INT || A0.m_type == T_DBL)
+            || A0.to_dbl() < 1.0)
+            error("bkl-gc-heap-growth expects a number >= 1.0", A0);
+        out = Atom(T_DBL);
+        out.m_d.d = m_rt->m_gc.get_heap_growth();
+        m_rt->m_gc.set_heap_growth(A0.to_dbl());
+    }
+    else
+    {
+        out = Atom(T_DBL);
+        out.m_d.d = m_rt->m_gc.get_heap_growth();
+    }
+END_PRIM_DOC(bkl-gc-heap-growth,
+"@internal procedure (bkl-gc-heap-growth [_factor_])\n"
+"\n"
+"Returns the factor by which the heap may grow, before the next\n"
+"major garbage collection is done. The heap size after the last\n"
+"major collection is the base. If _factor_ is given, it sets a\n"
+"new factor and returns the old one.\n"
+)
+
+START_PRIM()
+    if (args.m_len > 0)
+    {
+        if (A0.m_type != T_INT || A0.m_d.i < 0)
+            error("bkl-gc-heap-min expects a positive integer", A0);
+        out = Atom(T_INT, (int64_t) m_rt->m_gc.get_heap_min_bytes());
+        m_rt->m_gc.set_heap_min_bytes((size_t) A0.m_d.i);
+    }
+    else
+        out = Atom(T_INT, (int64_t) m_rt->m_gc.get_heap_min_bytes());
+END_PRIM_DOC(bkl-gc-heap-min,
+"@internal procedure (bkl-gc-heap-min [_bytes_])\n"
+"\n"
+"Returns the number of bytes the heap may always grow to,\n"
+"before a major garbage collection is done. If _bytes_ is given,\n"
+"it sets a new minimum and returns the old one.\n"
+)
+
+START_PRIM()
+    if (args.m_len > 0)
+    {
+        if (A0.m_type != T_INT || A0.m_d.i < 0)
+            error("bkl-gc-heap-soft-limit expects a positive integer", A0);
+        out = Atom(T_INT, (int64_t) m_rt->m_gc.get_heap_soft_limit_bytes());
+        m_rt->m_gc.set_heap_soft_limit_bytes((size_t) A0.m_d.i);
+    }
+    else
+        out = Atom(T_INT, (int64_t) m_rt->m_gc.get_heap_soft_limit_bytes());
+END_PRIM_DOC(bkl-gc-heap-soft-limit,
+"@internal procedure (bkl-gc-heap-soft-limit [_bytes_])\n"
+"\n"
+"Returns the size in bytes, above which the heap only grows\n"
+"by a quarter between major garbage collections. 0 means no\n"
+"limit. If _bytes_ is given, it sets a new limit and returns\n"
+"the old one.\n"
+)
+
 START_PRIM()
     REQ_EQ_ARGC(bkl-primitive-map, 0);
     out = Atom(T_MAP, m_rt->m_gc.allocate_map());
@@ -1261,7 +1437,7 @@ START_PRIM()
         "or keyword as first argument.");
     out =
         Atom(T_STR,
-            m_rt->m_gc.new_symbol(
+            m_rt->m_gc.new_string(
                 m_rt->find_in_libdirs(A0.m_d.sym->m_str)));
 END_PRIM_DOC(bkl-find-lib-file,
 "@runtime procedure (bkl-find-lib-file _string_)\n\n"
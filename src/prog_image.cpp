@@ -0,0 +1,704 @@
+// Copyright (C) 2017 Weird Constructor
+// For more license info refer to the the bottom of this file.
+
+#include "prog_image.h"
+#include "vmprog.h"
+#include "util.h"
+#include <unordered_map>
+#include <fstream>
+#include <cstring>
+
+#if defined(WIN32) || defined(_WIN32)
+#else
+extern "C"
+{
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+}
+#endif
+
+using namespace std;
+
+namespace bukalisp
+{
+//---------------------------------------------------------------------------
+
+enum ProgImageObjKind : uint8_t
+{
+    PIMG_STR,       // u32:len bytes
+    PIMG_SYM,       // u32:len bytes (interned, for symbols, keywords, syntax)
+    PIMG_VEC,       // u32:meta+1 u32:len atoms
+    PIMG_MAP,       // u32:meta+1 u32:count (key-atom value-atom)*
+    PIMG_PROG,      // u32:data-len u32:instr-len u32:root-regs+1
+                    // [u32:frame-size u32:root-size u32:fused-count]
+                    // str:func-info atom:debug-info atoms:data
+                    // instructions (op oe ae be ce o a b c)
+};
+
+#define PIMG_ATOM_SIZE  9
+#define PIMG_INST_SIZE  21
+//---------------------------------------------------------------------------
+
+// Hash over the opcode table and the build flags that decide, which
+// opcodes PROG::specialize() and quickening produce:
+static uint64_t op_table_hash()
+{
+    static uint64_t hash = 0;
+    if (hash)
+        return hash;
+
+    std::string tbl;
+#   define X(name, code)        tbl += #name ":" + to_string(code) + ";";
+#   define XS(name, code, base) tbl += #name ":" + to_string(code) + ":" #base ";";
+    OP_CODE_DEF(X)
+    OP_SPEC_CODE_DEF(XS)
+#   undef XS
+#   undef X
+    tbl += "Q" + to_string(WITH_QUICKENING);
+    tbl += "S" + to_string(WITH_SUPERINSTRUCTIONS);
+
+    hash = hash_fnv1a(tbl);
+    return hash;
+}
+//---------------------------------------------------------------------------
+
+class ProgImageWriter
+{
+    private:
+        unordered_map<void *, uint32_t> m_index;
+        vector<Atom>                    m_objects;
+        string                          m_out;
+        uint32_t                        m_flags;
+
+    public:
+        ProgImageWriter(uint32_t flags) : m_flags(flags) { }
+
+        void put_u8(uint8_t v) { m_out.push_back((char) v); }
+
+        void put_u32(uint32_t v)
+        {
+            for (int i = 0; i < 4; i++)
+                m_out.push_back((char) ((v >> (i * 8)) & 0xFF));
+        }
+
+        void put_u64(uint64_t v)
+        {
+            for (int i = 0; i < 8; i++)
+                m_out.push_back((char) ((v >> (i * 8)) & 0xFF));
+        }
+
+        void put_str(const string &s)
+        {
+            put_u32((uint32_t) s.size());
+            m_out.append(s);
+        }
+
+        // Returns the object index of the heap object the atom refers to,
+        // new objects are queued up for write().
+        uint32_t ref(void *ptr, const Atom &a)
+        {
+            auto it = m_index.find(ptr);
+            if (it != m_index.end())
+                return it->second;
+
+            uint32_t idx = (uint32_t) m_objects.size();
+            m_index[ptr] = idx;
+            m_objects.push_back(a);
+            return idx;
+        }
+
+        uint32_t ref_vec(AtomVec *v)
+        {
+            if (!v) return 0;
+            return ref(v, Atom(T_VEC, v)) + 1;
+        }
+
+        void put_atom(const Atom &a)
+        {
+            put_u8((uint8_t) a.m_type);
+
+            switch (a.m_type)
+            {
+                case T_NIL:    put_u64(0); break;
+                case T_INT:    put_u64((uint64_t) a.m_d.i); break;
+                case T_BOOL:   put_u64(a.m_d.b ? 1 : 0); break;
+                case T_DBL:
+                {
+                    uint64_t bits;
+                    memcpy(&bits, &a.m_d.d, sizeof(bits));
+                    put_u64(bits);
+                    break;
+                }
+                case T_STR:
+                case T_SYM:
+                case T_KW:
+                case T_SYNTAX:
+                    put_u64(ref(a.m_d.sym, a));
+                    break;
+                case T_VEC:
+                case T_CLOS:
+                    put_u64(ref(a.m_d.vec, Atom(T_VEC, a.m_d.vec)));
+                    break;
+                case T_MAP:
+                    put_u64(ref(a.m_d.map, a));
+                    break;
+                case T_UD:
+                    if (!a.m_d.ud || a.m_d.ud->type() != "BKL-VM-PROG")
+                        throw BukaLISPException(
+                            "Can only write BKL-VM-PROG T_UD into a "
+                            "PROG image: " + a.to_write_str());
+                    put_u64(ref(a.m_d.ud, a));
+                    break;
+                default:
+                    throw BukaLISPException(
+                        "Can't write atom into a PROG image: "
+                        + a.to_write_str());
+            }
+        }
+
+        void write_object(const Atom &a)
+        {
+            switch (a.m_type)
+            {
+                case T_STR:
+                    put_u8(PIMG_STR);
+                    put_str(a.m_d.sym->m_str);
+                    break;
+                case T_SYM:
+                case T_KW:
+                case T_SYNTAX:
+                    put_u8(PIMG_SYM);
+                    put_str(a.m_d.sym->m_str);
+                    break;
+                case T_VEC:
+                {
+                    AtomVec *v = a.m_d.vec;
+                    put_u8(PIMG_VEC);
+                    put_u32(ref_vec(v->m_meta));
+                    put_u32((uint32_t) v->m_len);
+                    for (size_t i = 0; i < v->m_len; i++)
+                        put_atom(v->m_data[i]);
+                    break;
+                }
+                case T_MAP:
+                {
+                    AtomMap *m = a.m_d.map;
+                    put_u8(PIMG_MAP);
+                    put_u32(ref_vec(m->m_meta));
+                    put_u32((uint32_t) m->size());
+                    ATOM_MAP_FOR(i, m)
+                    {
+                        put_atom(MAP_ITER_KEY(i));
+                        put_atom(MAP_ITER_VAL(i));
+                    }
+                    break;
+                }
+                case T_UD:
+                {
+                    PROG *prog = static_cast<PROG *>(a.m_d.ud);
+                    put_u8(PIMG_PROG);
+                    put_u32((uint32_t) prog->m_data_vec->m_len);
+                    put_u32((uint32_t) prog->m_instructions_len);
+                    put_u32(ref_vec(prog->m_root_regs));
+                    if (m_flags & BKL_PROG_IMAGE_SNAPSHOT)
+                    {
+                        put_u32((uint32_t) prog->m_frame_size);
+                        put_u32((uint32_t) prog->m_root_size);
+                        put_u32((uint32_t) prog->m_fused_count);
+                    }
+                    put_str(prog->m_function_info);
+                    put_atom(prog->m_debug_info_map);
+
+                    for (size_t i = 0; i < prog->m_data_vec->m_len; i++)
+                        put_atom(prog->m_data_vec->m_data[i]);
+
+                    for (size_t i = 0; i < prog->m_instructions_len; i++)
+                    {
+                        INST &ins = prog->m_instructions[i];
+                        // Unless we write a snapshot, specialize()
+                        // is run again by the loader:
+                        put_u8(  (m_flags & BKL_PROG_IMAGE_SNAPSHOT)
+                               ? ins.op
+                               : INST::base_op(ins.op));
+                        put_u8((uint8_t) ins.oe);
+                        put_u8((uint8_t) ins.ae);
+                        put_u8((uint8_t) ins.be);
+                        put_u8((uint8_t) ins.ce);
+                        put_u32((uint32_t) ins.o);
+                        put_u32((uint32_t) ins.a);
+                        put_u32((uint32_t) ins.b);
+                        put_u32((uint32_t) ins.c);
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+
+        string write(const Atom &root)
+        {
+            put_atom(root);
+
+            // write_object() queues up new objects while we iterate:
+            for (size_t i = 0; i < m_objects.size(); i++)
+            {
+                Atom obj = m_objects[i];
+                write_object(obj);
+            }
+
+            string body;
+            body.swap(m_out);
+
+            m_out.append(BKL_PROG_IMAGE_MAGIC, 4);
+            put_u32(BKL_PROG_IMAGE_VERSION);
+            put_u32(m_flags);
+            if (m_flags & BKL_PROG_IMAGE_SNAPSHOT)
+                put_u64(op_table_hash());
+            put_u32((uint32_t) m_objects.size());
+            m_out.append(body);
+
+            return m_out;
+        }
+};
+//---------------------------------------------------------------------------
+
+class ProgImageReader
+{
+    private:
+        GC          &m_gc;
+        const char  *m_data;
+        size_t       m_len;
+        size_t       m_pos;
+        AtomVec     *m_objects;
+        uint32_t     m_flags;
+        // Start of the body of each object, for relocate_objects():
+        vector<size_t> m_offsets;
+
+        void fail(const string &msg)
+        {
+            throw BukaLISPException(
+                "Bad PROG image at offset "
+                + to_string(m_pos) + ": " + msg);
+        }
+
+    public:
+        ProgImageReader(GC &gc, const char *data, size_t len)
+            : m_gc(gc), m_data(data), m_len(len), m_pos(0),
+              m_objects(nullptr), m_flags(0)
+        {
+        }
+
+        void need(size_t n)
+        {
+            if (n > m_len || m_pos > m_len - n)
+                fail("unexpected end of image");
+        }
+
+        void skip(size_t n) { need(n); m_pos += n; }
+
+        uint8_t get_u8()
+        {
+            need(1);
+            return (uint8_t) m_data[m_pos++];
+        }
+
+        uint32_t get_u32()
+        {
+            need(4);
+            uint32_t v = 0;
+            for (int i = 0; i < 4; i++)
+                v |= ((uint32_t) (uint8_t) m_data[m_pos++]) << (i * 8);
+            return v;
+        }
+
+        uint64_t get_u64()
+        {
+            need(8);
+            uint64_t v = 0;
+            for (int i = 0; i < 8; i++)
+                v |= ((uint64_t) (uint8_t) m_data[m_pos++]) << (i * 8);
+            return v;
+        }
+
+        string get_str()
+        {
+            uint32_t len = get_u32();
+            need(len);
+            string s(m_data + m_pos, len);
+            m_pos += len;
+            return s;
+        }
+
+        Atom &object(uint64_t idx)
+        {
+            if (idx >= m_objects->m_len)
+                fail("object index out of range");
+            return m_objects->m_data[idx];
+        }
+
+        AtomVec *get_vec_ref()
+        {
+            uint32_t idx = get_u32();
+            if (idx == 0)
+                return nullptr;
+            Atom &a = object(idx - 1);
+            if (a.m_type != T_VEC)
+                fail("expected a reference to a list");
+            return a.m_d.vec;
+        }
+
+        Atom get_atom()
+        {
+            Type     t = (Type) get_u8();
+            uint64_t v = get_u64();
+
+            Atom a(t);
+            switch (t)
+            {
+                case T_NIL:  break;
+                case T_INT:  a.m_d.i = (int64_t) v; break;
+                case T_BOOL: a.m_d.b = v != 0; break;
+                case T_DBL:  memcpy(&a.m_d.d, &v, sizeof(v)); break;
+                case T_STR:
+                case T_SYM:
+                case T_KW:
+                case T_SYNTAX:
+                    if (   object(v).m_type != T_STR
+                        && object(v).m_type != T_SYM)
+                        fail("expected a reference to a string or symbol");
+                    a.m_d.sym = object(v).m_d.sym;
+                    break;
+                case T_VEC:
+                case T_CLOS:
+                    if (object(v).m_type != T_VEC)
+                        fail("expected a reference to a list");
+                    a.m_d.vec = object(v).m_d.vec;
+                    break;
+                case T_MAP:
+                    if (object(v).m_type != T_MAP)
+                        fail("expected a reference to a map");
+                    a.m_d.map = object(v).m_d.map;
+                    break;
+                case T_UD:
+                    if (object(v).m_type != T_UD)
+                        fail("expected a reference to a PROG");
+                    a.m_d.ud = object(v).m_d.ud;
+                    break;
+                default:
+                    fail("bad atom type " + to_string((int) t));
+            }
+            return a;
+        }
+
+        // First pass: Allocates all objects, so that atoms can refer
+        // to objects that come later in the image.
+        void allocate_objects()
+        {
+            for (size_t i = 0; i < m_objects->m_len; i++)
+            {
+                uint8_t kind = get_u8();
+                m_offsets[i] = m_pos;
+
+                Atom &obj = m_objects->m_data[i];
+                switch (kind)
+                {
+                    case PIMG_STR:
+                        obj = Atom(T_STR, m_gc.new_string(get_str()));
+                        break;
+                    case PIMG_SYM:
+                        obj = Atom(T_SYM, m_gc.new_symbol(get_str()));
+                        break;
+                    case PIMG_VEC:
+                    {
+                        get_u32();
+                        uint32_t len = get_u32();
+                        skip((size_t) len * PIMG_ATOM_SIZE);
+                        obj = Atom(T_VEC, m_gc.allocate_vector(len));
+                        break;
+                    }
+                    case PIMG_MAP:
+                    {
+                        get_u32();
+                        uint32_t cnt = get_u32();
+                        skip((size_t) cnt * 2 * PIMG_ATOM_SIZE);
+                        obj = Atom(T_MAP, m_gc.allocate_map());
+                        break;
+                    }
+                    case PIMG_PROG:
+                    {
+                        uint32_t data_len  = get_u32();
+                        uint32_t instr_len = get_u32();
+                        get_u32();
+                        if (m_flags & BKL_PROG_IMAGE_SNAPSHOT)
+                            skip(3 * 4);
+                        skip(get_u32());
+                        skip(PIMG_ATOM_SIZE);
+                        skip((size_t) data_len  * PIMG_ATOM_SIZE);
+                        skip((size_t) instr_len * PIMG_INST_SIZE);
+
+                        PROG *prog = new PROG(m_gc, data_len, instr_len);
+                        m_gc.reg_userdata(prog);
+                        obj = Atom(T_UD);
+                        obj.m_d.ud = prog;
+                        break;
+                    }
+                    default:
+                        fail("bad object kind " + to_string((int) kind));
+                }
+            }
+        }
+
+        // Second pass: Fills the allocated objects, relocating the object
+        // indices of the image to the objects allocated above.
+        void relocate_objects()
+        {
+            for (size_t i = 0; i < m_objects->m_len; i++)
+            {
+                m_pos = m_offsets[i];
+                Atom obj = m_objects->m_data[i];
+
+                switch (obj.m_type)
+                {
+                    case T_VEC:
+                    {
+                        AtomVec *v = obj.m_d.vec;
+                        v->m_meta = get_vec_ref();
+                        uint32_t len = get_u32();
+                        for (uint32_t j = 0; j < len; j++)
+                            v->set(j, get_atom());
+                        break;
+                    }
+                    case T_MAP:
+                    {
+                        AtomMap *m = obj.m_d.map;
+                        m->m_meta = get_vec_ref();
+                        uint32_t cnt = get_u32();
+                        for (uint32_t j = 0; j < cnt; j++)
+                        {
+                            Atom key = get_atom();
+                            Atom val = get_atom();
+                            m->set(key, val);
+                        }
+                        break;
+                    }
+                    default:
+                        break;
+                }
+            }
+
+            // PROGs come last, as they check their root registers
+            // and specialize() on them:
+            for (size_t i = 0; i < m_objects->m_len; i++)
+            {
+                Atom obj = m_objects->m_data[i];
+                if (obj.m_type != T_UD)
+                    continue;
+
+                m_pos = m_offsets[i];
+                relocate_prog(static_cast<PROG *>(obj.m_d.ud));
+            }
+        }
+
+        void relocate_prog(PROG *prog)
+        {
+            uint32_t data_len  = get_u32();
+            uint32_t instr_len = get_u32();
+            AtomVec *root_regs = get_vec_ref();
+            if (!root_regs || !root_regs->m_meta)
+                fail("PROG without root registers");
+
+            bool snapshot = (m_flags & BKL_PROG_IMAGE_SNAPSHOT) != 0;
+            if (snapshot)
+            {
+                prog->m_frame_size  = get_u32();
+                prog->m_root_size   = get_u32();
+                prog->m_fused_count = get_u32();
+            }
+
+            prog->set_root_env(root_regs);
+            prog->m_function_info = get_str();
+            Atom debug = get_atom();
+            prog->set_debug_info(debug);
+
+            for (uint32_t i = 0; i < data_len; i++)
+                prog->m_data_vec->set(i, get_atom());
+
+            for (uint32_t i = 0; i < instr_len; i++)
+            {
+                INST ins;
+                ins.op = get_u8();
+                ins.oe = (int8_t) get_u8();
+                ins.ae = (int8_t) get_u8();
+                ins.be = (int8_t) get_u8();
+                ins.ce = (int8_t) get_u8();
+                ins.o  = (int32_t) get_u32();
+                ins.a  = (int32_t) get_u32();
+                ins.b  = (int32_t) get_u32();
+                ins.c  = (int32_t) get_u32();
+                prog->set(i, ins);
+            }
+
+            if (snapshot)
+            {
+                if (prog->m_root_size > 0)
+                    root_regs->check_size(prog->m_root_size - 1);
+            }
+            else
+                prog->specialize();
+        }
+
+        Atom read()
+        {
+            if (!is_prog_image(m_data, m_len))
+                fail("not a PROG image");
+            skip(4);
+
+            uint32_t version = get_u32();
+            if (version != BKL_PROG_IMAGE_VERSION)
+                fail("unsupported version " + to_string(version));
+
+            m_flags = get_u32();
+            if (   (m_flags & BKL_PROG_IMAGE_SNAPSHOT)
+                && get_u64() != op_table_hash())
+                fail("snapshot was written by a build with other opcodes");
+
+            uint32_t obj_count = get_u32();
+            // Each object takes at least 5 bytes, this guards the
+            // allocation below against garbage counts:
+            if ((size_t) obj_count > m_len / 5)
+                fail("bad object count");
+
+            GC_ROOT_VEC(m_gc, objects) = m_gc.allocate_vector(obj_count);
+            objects->m_len = obj_count;
+            m_objects = objects;
+            m_offsets.resize(obj_count);
+
+            size_t root_pos = m_pos;
+            skip(PIMG_ATOM_SIZE);
+
+            allocate_objects();
+            relocate_objects();
+
+            m_pos = root_pos;
+            Atom root = get_atom();
+            m_objects = nullptr;
+            return root;
+        }
+};
+//---------------------------------------------------------------------------
+
+std::string write_prog_image(GC &gc, const Atom &root, uint32_t flags)
+{
+    (void) gc;
+    ProgImageWriter w(flags);
+    return w.write(root);
+}
+//---------------------------------------------------------------------------
+
+Atom read_prog_image(GC &gc, const char *data, size_t len)
+{
+    ProgImageReader r(gc, data, len);
+    return r.read();
+}
+//---------------------------------------------------------------------------
+
+bool is_prog_image(const char *data, size_t len)
+{
+    return len >= 4 && memcmp(data, BKL_PROG_IMAGE_MAGIC, 4) == 0;
+}
+//---------------------------------------------------------------------------
+
+bool is_prog_image_file(const std::string &filepath)
+{
+    ifstream input_file(filepath.c_str(), ios::in | ios::binary);
+    if (!input_file.is_open())
+        return false;
+
+    char magic[4];
+    input_file.read(magic, 4);
+    return is_prog_image(magic, (size_t) input_file.gcount());
+}
+//---------------------------------------------------------------------------
+
+bool save_prog_image_file(
+    GC &gc, const std::string &filepath, const Atom &root, uint32_t flags)
+{
+    return write_str(filepath, write_prog_image(gc, root, flags));
+}
+//---------------------------------------------------------------------------
+
+Atom load_prog_image_file(GC &gc, const std::string &filepath)
+{
+#if defined(WIN32) || defined(_WIN32)
+    ifstream input_file(filepath.c_str(),
+                        ios::in | ios::binary | ios::ate);
+    if (!input_file.is_open())
+        throw BukaLISPException("Couldn't open '" + filepath + "'");
+
+    std::string data((size_t) input_file.tellg(), '\0');
+    input_file.seekg(0, ios::beg);
+    input_file.read(&data[0], data.size());
+
+    return read_prog_image(gc, data.data(), data.size());
+#else
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw BukaLISPException("Couldn't open '" + filepath + "'");
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        throw BukaLISPException("Couldn't stat or empty '" + filepath + "'");
+    }
+
+    size_t len = (size_t) st.st_size;
+    void *map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        throw BukaLISPException("Couldn't mmap '" + filepath + "'");
+
+    Atom root;
+    try
+    {
+        root = read_prog_image(gc, (const char *) map, len);
+    }
+    catch (...)
+    {
+        munmap(map, len);
+        throw;
+    }
+    munmap(map, len);
+
+    return root;
+#endif
+}
+//---------------------------------------------------------------------------
+
+}
+
+/******************************************************************************
+* Copyright (C) 2017 Weird Constructor
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
@@ -0,0 +1,76 @@
+// Copyright (C) 2017 Weird Constructor
+// For more license info refer to the the bottom of this file.
+
+#pragma once
+
+#include "atom.h"
+
+namespace bukalisp
+{
+//---------------------------------------------------------------------------
+
+// Binary image of an atom tree that contains compiled BKL-VM-PROGs.
+// In contrast to PROG::to_atom() (text) and atom2cpp() (C++ source) it can
+// be loaded without running the reader or the BukaLISP compiler.
+//
+// Layout (all integers are little endian):
+//
+//   header:  "BKLC" u32:version u32:flags [u64:op-table-hash]
+//            u32:object-count atom:root
+//   atom:    u8:type u64:payload   (int, double bits, bool or object index)
+//   objects: u8:kind followed by the kind specific body, in index order
+//
+// Atoms refer to strings, symbols, lists, maps and PROGs only by their
+// object index. The loader allocates all objects first and then
+// relocates the indices to the freshly allocated objects.
+//
+// Like the text serialization, the instructions refer to primitives by
+// their index in the primitive table of the VM. An image has to be
+// rewritten when primitives are added or removed.
+//
+// Images written with BKL_PROG_IMAGE_SNAPSHOT keep the instructions as
+// PROG::specialize() (and quickening) left them, together with the row
+// sizes it computed. Loading them skips specialize(), but they are only
+// accepted by a build with the same opcode table (op-table-hash).
+
+#define BKL_PROG_IMAGE_MAGIC    "BKLC"
+#define BKL_PROG_IMAGE_VERSION  2
+
+#define BKL_PROG_IMAGE_SNAPSHOT 0x1
+
+std::string write_prog_image(GC &gc, const Atom &root, uint32_t flags = 0);
+Atom read_prog_image(GC &gc, const char *data, size_t len);
+bool is_prog_image(const char *data, size_t len);
+
+bool is_prog_image_file(const std::string &filepath);
+bool save_prog_image_file(GC &gc, const std::string &filepath,
+                          const Atom &root, uint32_t flags = 0);
+// Maps the file into memory (if the platform supports it) and
+// reads the image from there.
+Atom load_prog_image_file(GC &gc, const std::string &filepath);
+
+//---------------------------------------------------------------------------
+}
+
+/******************************************************************************
+* Copyright (C) 2017 Weird Constructor
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************/
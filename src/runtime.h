@@ -22,9 +22,15 @@ struct Runtime
 
     std::vector<std::string> m_library_dir_paths;
 
+    // Paths of the files read by 'sys-slurp-file' while m_log_file_reads
+    // is set. The CompileCache uses them to notice changed include files.
+    std::vector<std::string> m_file_read_log;
+    bool                     m_log_file_reads;
+
     Runtime()
         : m_ag(&m_gc),
-          m_par(m_tok, &m_ag)
+          m_par(m_tok, &m_ag),
+          m_log_file_reads(false)
     {
         init_lib_dir_paths();
     }
@@ -63,6 +69,17 @@ struct Runtime
     size_t pot_alive_syms() { return m_gc.count_potentially_alive_syms(); }
 
     void collect() { m_gc.collect(); }
+
+    // Configures when major collections are done, a soft_limit_bytes
+    // of 0 means no limit. See GC::update_heap_target().
+    void set_gc_heap_policy(double growth, size_t min_bytes, size_t soft_limit_bytes)
+    {
+        m_gc.set_heap_growth(growth);
+        m_gc.set_heap_min_bytes(min_bytes);
+        m_gc.set_heap_soft_limit_bytes(soft_limit_bytes);
+    }
+
+    size_t gc_heap_bytes() { return m_gc.heap_bytes(); }
 };
 
 //---------------------------------------------------------------------------
@@ -16,7 +16,7 @@ class SymHash
 {
     public:
         size_t operator()(const Sym *&s) const
-        { return std::hash<std::string>()(s->m_str); }
+        { return s->m_hash; }
 };
 //---------------------------------------------------------------------------
 
@@ -53,7 +53,8 @@ class SymTable
             if (it == m_syms.end())
             {
                 Sym *newsym = m_gc->allocate_sym();
-                newsym->m_str = s;
+                newsym->m_str  = s;
+                newsym->m_hash = std::hash<std::string>()(s);
                 m_syms.insert(std::pair<std::string, Sym *>(s, newsym));
                 return newsym;
             }
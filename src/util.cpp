@@ -17,6 +17,8 @@ extern "C"
 {
 #  include <unistd.h>
 #  include <libgen.h>
+#  include <errno.h>
+#  include <sys/stat.h>
 }
 #endif
 
@@ -115,6 +117,18 @@ std::string slurp_str(const std::string &filepath)
 }
 //---------------------------------------------------------------------------
 
+uint64_t hash_fnv1a(const std::string &data, uint64_t seed)
+{
+    uint64_t h = 14695981039346656037ULL ^ seed;
+    for (auto c : data)
+    {
+        h ^= (uint64_t) (uint8_t) c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+//---------------------------------------------------------------------------
+
 std::string from_wstring(const std::wstring &wstr)
 {
     std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> utf8_utf16_converter;
@@ -165,6 +179,17 @@ bool file_exists(const std::string &filename)
 }
 //---------------------------------------------------------------------------
 
+bool create_dir(const std::string &dirpath)
+{
+#if defined(WIN32) || defined(_WIN32)
+    return    CreateDirectoryW(to_wstring(dirpath).c_str(), NULL) != 0
+           || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    return mkdir(dirpath.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+//---------------------------------------------------------------------------
+
 /******************************************************************************
 * Copyright (C) 2017 Weird Constructor
 *
@@ -3,14 +3,19 @@
 
 #include <string>
 #include <chrono>
+#include <cstdint>
 
 std::string slurp_str(const std::string &filepath);
 bool write_str(const std::string &filepath, const std::string &data);
+// 64 bit FNV-1a hash, it is stable across platforms and builds:
+uint64_t hash_fnv1a(const std::string &data, uint64_t seed = 0);
 
 std::string from_wstring(const std::wstring &str);
 std::wstring to_wstring(const std::string &str);
 std::string application_dir_path();
 bool file_exists(const std::string &filename);
+// Returns true if the directory was created or already exists.
+bool create_dir(const std::string &dirpath);
 
 class BenchmarkTimer
 {
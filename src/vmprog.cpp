@@ -270,10 +270,257 @@ Atom PROG::create_prog_from_info(GC &gc, Atom prog_info, AtomMap *refmap)
         new_prog->set(i, instr);
     }
 
+    new_prog->specialize();
+
     return ret;
 }
 //---------------------------------------------------------------------------
 
+// Returns false for operands that are not register references,
+// like branch offsets or vector lengths.
+static bool inst_operand_is_reg(uint8_t op, char operand)
+{
+    switch (INST::base_op(op))
+    {
+        case OP_BR:
+        case OP_BRIF:
+        case OP_BRNIF:
+            return operand != 'o';
+        case OP_PUSH_JMP:
+        case OP_PUSH_CLNUP:
+        case OP_NEW_VEC:
+        case OP_NEW_ARG_VEC:
+            return operand != 'a';
+        default:
+            return true;
+    }
+}
+//---------------------------------------------------------------------------
+
+// Returns true if the result of the CALL at call_idx is returned
+// right away. The compiler moves it into the result register of
+// an enclosing (if ...) or (begin ...) and branches to the RETURN
+// from there, so these moves and branches are followed.
+static bool inst_call_is_tail(INST *instructions, size_t len, size_t call_idx)
+{
+    int32_t res   = instructions[call_idx].o;
+    int8_t  res_e = instructions[call_idx].oe;
+    size_t  i     = call_idx + 1;
+
+    // Limits the number of steps, in case the branches form a loop:
+    for (int steps = 0; i < len && steps < 16; steps++)
+    {
+        INST &inst = instructions[i];
+        switch (INST::base_op(inst.op))
+        {
+            case OP_NOP:
+                i++;
+                break;
+            case OP_MOV:
+                if (inst.a != res || inst.ae != res_e)
+                    return false;
+                res   = inst.o;
+                res_e = inst.oe;
+                i++;
+                break;
+            case OP_BR:
+                if (inst.o < 0 && (size_t) (-inst.o) > i)
+                    return false;
+                i = (size_t) ((int64_t) i + inst.o + 1);
+                break;
+            case OP_RETURN:
+                return inst.o == res && inst.oe == res_e;
+            default:
+                return false;
+        }
+    }
+
+    return false;
+}
+//---------------------------------------------------------------------------
+
+static char inst_row_letter(int8_t e)
+{
+    switch (e)
+    {
+        case REG_ROW_FRAME: return 'F';
+        case REG_ROW_DATA:  return 'D';
+        case REG_ROW_ROOT:  return 'R';
+        default:            return '?';
+    }
+}
+//---------------------------------------------------------------------------
+
+void PROG::specialize()
+{
+    m_frame_size = 0;
+    m_root_size  = 0;
+
+    for (size_t i = 0; i < m_instructions_len; i++)
+    {
+        INST &inst = m_instructions[i];
+
+        const char *operands = "oabc";
+        for (const char *opd = operands; *opd; opd++)
+        {
+            if (!inst_operand_is_reg(inst.op, *opd))
+                continue;
+
+            int32_t idx = 0;
+            int8_t  e   = 0;
+            switch (*opd)
+            {
+                case 'o': idx = inst.o; e = inst.oe; break;
+                case 'a': idx = inst.a; e = inst.ae; break;
+                case 'b': idx = inst.b; e = inst.be; break;
+                case 'c': idx = inst.c; e = inst.ce; break;
+            }
+            if (idx < 0)
+                continue;
+
+            switch (e)
+            {
+                case REG_ROW_FRAME:
+                case REG_ROW_UPV:
+                    // + 2, because some ops (eg. the cleanup jumps)
+                    // also write the register after the output register.
+                    if (m_frame_size < (size_t) idx + 2)
+                        m_frame_size = (size_t) idx + 2;
+                    break;
+                case REG_ROW_ROOT:
+                case REG_ROW_RREF:
+                    if (m_root_size < (size_t) idx + 1)
+                        m_root_size = (size_t) idx + 1;
+                    break;
+            }
+        }
+
+        if (   inst.op == OP_CALL
+            && inst_call_is_tail(m_instructions, m_instructions_len, i))
+        {
+            inst.op = OP_TAILCALL;
+            continue;
+        }
+
+        const char *pattern = nullptr;
+        switch (inst.op)
+        {
+            case OP_MOV:    pattern = "oa";   break;
+            case OP_BRIF:
+            case OP_BRNIF:  pattern = "a";    break;
+            case OP_FORINC: pattern = "oabc"; break;
+            case OP_GET:    pattern = "oab";  break;
+            case OP_ADD:
+            case OP_SUB:
+            case OP_MUL:
+            case OP_LT:
+            case OP_GT:
+            case OP_LE:
+            case OP_GE:     pattern = "oab";  break;
+        }
+        if (!pattern)
+            continue;
+
+        std::string spec_name = inst.get_op_name() + "_";
+        for (const char *opd = pattern; *opd; opd++)
+        {
+            switch (*opd)
+            {
+                case 'o': spec_name += inst_row_letter(inst.oe); break;
+                case 'a': spec_name += inst_row_letter(inst.ae); break;
+                case 'b': spec_name += inst_row_letter(inst.be); break;
+                case 'c': spec_name += inst_row_letter(inst.ce); break;
+            }
+        }
+
+        uint8_t spec_op = INST::op_from_name(spec_name);
+        if (spec_op != (uint8_t) -1)
+            inst.op = spec_op;
+    }
+
+    m_fused_count = 0;
+#if WITH_SUPERINSTRUCTIONS
+    for (size_t i = 0; i + 1 < m_instructions_len; i++)
+    {
+        INST &inst = m_instructions[i];
+        INST &next = m_instructions[i + 1];
+
+        const char *suffix = nullptr;
+        switch (next.op)
+        {
+            case OP_BRIF_F:  suffix = "_BRIF";  break;
+            case OP_BRNIF_F: suffix = "_BRNIF"; break;
+        }
+        if (!suffix || inst.oe != REG_ROW_FRAME || next.a != inst.o)
+            continue;
+
+        uint8_t fused_op = INST::op_from_name(inst.get_op_name() + suffix);
+        if (fused_op == (uint8_t) -1)
+            continue;
+
+        inst.op = fused_op;
+        m_fused_count++;
+        i++; // the branch can't start another pair
+    }
+#endif
+
+    // The root registers are shared with the compiler, which already
+    // reserves them when it assigns the index. This is just for
+    // PROGs that come from elsewhere:
+    if (m_root_regs && m_root_size > 0)
+        m_root_regs->check_size(m_root_size - 1);
+
+    // Threading happens after specialization, which changes the handlers:
+    m_threaded = false;
+}
+//---------------------------------------------------------------------------
+
+std::string PROG::disassemble()
+{
+    std::string out =
+        ";; " + m_function_info
+        + " frame-size=" + std::to_string(m_frame_size)
+        + " root-size="  + std::to_string(m_root_size)
+        + " fused="      + std::to_string(m_fused_count) + "\n";
+
+    for (size_t i = 0; i < m_instructions_len; i++)
+    {
+        INST &inst = m_instructions[i];
+
+        std::string line = std::to_string(i) + ":";
+        while (line.size() < 6)
+            line += " ";
+        line += inst.get_op_name();
+        while (line.size() < 24)
+            line += " ";
+
+        const char *operands = "oabc";
+        for (const char *opd = operands; *opd; opd++)
+        {
+            int32_t idx = 0;
+            int8_t  e   = 0;
+            switch (*opd)
+            {
+                case 'o': idx = inst.o; e = inst.oe; break;
+                case 'a': idx = inst.a; e = inst.ae; break;
+                case 'b': idx = inst.b; e = inst.be; break;
+                case 'c': idx = inst.c; e = inst.ce; break;
+            }
+
+            line += " ";
+            if (inst_operand_is_reg(inst.op, *opd))
+                line += INST::regidx2string(idx, e);
+            else
+                line += std::to_string(idx);
+        }
+
+        out += line + "\n";
+    }
+
+    return out;
+}
+//---------------------------------------------------------------------------
+
 }
 
 /******************************************************************************
@@ -62,10 +62,126 @@ namespace bukalisp
     X(RETURN,       250) /*                                        */ \
     X(END,          254) /*                                        */
 
+//---------------------------------------------------------------------------
+
+// Operand specialized variants of the generic opcodes above.
+// They are not emitted by the compiler, PROG::specialize() rewrites
+// the instructions when a PROG is loaded. The suffix letters name the
+// register rows of the operands (in the order O A B C):
+//
+//      F = REG_ROW_FRAME, D = REG_ROW_DATA, R = REG_ROW_ROOT
+//
+// Their handlers access the rows directly and don't check the
+// size of the frame or root rows. PROG::m_frame_size and
+// PROG::m_root_size make sure that they are big enough.
+//
+// TAILCALL is a CALL whose result is returned right away. It reuses
+// the call frame of the current function instead of pushing a new one.
+//
+// GET_FFD is a GET with a constant key from the data row, like the
+// keyword in (:x m).
+#define OP_SPEC_NUM_DEF(X, base, code) \
+    X(base##_FFF, (code + 0), base) \
+    X(base##_FFD, (code + 1), base) \
+    X(base##_FRF, (code + 2), base) \
+    X(base##_FRD, (code + 3), base) \
+    X(base##_RFF, (code + 4), base) \
+    X(base##_RFD, (code + 5), base) \
+    X(base##_RRF, (code + 6), base) \
+    X(base##_RRD, (code + 7), base)
+
+#define OP_SPEC_CMP_DEF(X, base, code) \
+    X(base##_FFF, (code + 0), base) \
+    X(base##_FFD, (code + 1), base) \
+    X(base##_FRF, (code + 2), base) \
+    X(base##_FRD, (code + 3), base)
+
+// Superinstructions, see WITH_SUPERINSTRUCTIONS in config.h. They are
+// fused from an instruction and the BRIF_F or BRNIF_F after it, which
+// tests the output register of the first. The branch stays in the
+// code, so jumps to it keep working. The superinstruction only takes
+// the branch offset from it and then skips over it.
+#define OP_SUPER_CMP_DEF(X, base, code) \
+    X(base##_FFF_BRIF,  (code + 0), base) \
+    X(base##_FFD_BRIF,  (code + 1), base) \
+    X(base##_FFF_BRNIF, (code + 2), base) \
+    X(base##_FFD_BRNIF, (code + 3), base)
+
+#define OP_SPEC_CODE_DEF(X) \
+    X(MOV_FF,         35, MOV)    \
+    X(MOV_FD,         36, MOV)    \
+    X(MOV_FR,         37, MOV)    \
+    X(MOV_RF,         38, MOV)    \
+    X(MOV_RD,         39, MOV)    \
+    X(MOV_RR,         40, MOV)    \
+    X(BRIF_F,         41, BRIF)   \
+    X(BRNIF_F,        42, BRNIF)  \
+    X(FORINC_FFFF,    43, FORINC) \
+    X(FORINC_FFDF,    44, FORINC) \
+    X(FORINC_FDFF,    45, FORINC) \
+    X(FORINC_FDDF,    46, FORINC) \
+    X(TAILCALL,       47, CALL)   \
+    OP_SUPER_CMP_DEF(X, LT,  48)  \
+    OP_SUPER_CMP_DEF(X, GT,  52)  \
+    OP_SUPER_CMP_DEF(X, LE,  56)  \
+    OP_SUPER_CMP_DEF(X, GE,  60)  \
+    X(FORINC_FFFF_BRNIF, 64, FORINC) \
+    X(FORINC_FFDF_BRNIF, 65, FORINC) \
+    X(FORINC_FDFF_BRNIF, 66, FORINC) \
+    X(FORINC_FDDF_BRNIF, 67, FORINC) \
+    X(GET_FFD,        68, GET)    \
+    OP_SPEC_NUM_DEF(X, ADD, 120)  \
+    OP_SPEC_NUM_DEF(X, SUB, 128)  \
+    OP_SPEC_NUM_DEF(X, MUL, 136)  \
+    OP_SPEC_CMP_DEF(X, LT,  144)  \
+    OP_SPEC_CMP_DEF(X, GT,  148)  \
+    OP_SPEC_CMP_DEF(X, LE,  152)  \
+    OP_SPEC_CMP_DEF(X, GE,  156)  \
+    OP_QUICK_CODE_DEF(X, II, OP_QUICK_II_OFFS) \
+    OP_QUICK_CODE_DEF(X, DD, OP_QUICK_DD_OFFS)
+
+// Type quickened variants of the specialized arithmetic and comparison
+// instructions, for two T_INT (II) or two T_DBL (DD) operands. The VM
+// rewrites an instruction into them when it executes (see
+// WITH_QUICKENING in config.h), they are never emitted or loaded.
+// Their codes are the code of the specialized instruction plus
+// OP_QUICK_II_OFFS or OP_QUICK_DD_OFFS, which is used to switch
+// between them.
+#define OP_QUICK_II_OFFS 40
+#define OP_QUICK_DD_OFFS 80
+
+#define OP_QUICK_NUM_DEF(X, base, code, t) \
+    X(base##_FFF_##t, (code + 0), base) \
+    X(base##_FFD_##t, (code + 1), base) \
+    X(base##_FRF_##t, (code + 2), base) \
+    X(base##_FRD_##t, (code + 3), base) \
+    X(base##_RFF_##t, (code + 4), base) \
+    X(base##_RFD_##t, (code + 5), base) \
+    X(base##_RRF_##t, (code + 6), base) \
+    X(base##_RRD_##t, (code + 7), base)
+
+#define OP_QUICK_CMP_DEF(X, base, code, t) \
+    X(base##_FFF_##t, (code + 0), base) \
+    X(base##_FFD_##t, (code + 1), base) \
+    X(base##_FRF_##t, (code + 2), base) \
+    X(base##_FRD_##t, (code + 3), base)
+
+#define OP_QUICK_CODE_DEF(X, t, offs)           \
+    OP_QUICK_NUM_DEF(X, ADD, (120 + offs), t)   \
+    OP_QUICK_NUM_DEF(X, SUB, (128 + offs), t)   \
+    OP_QUICK_NUM_DEF(X, MUL, (136 + offs), t)   \
+    OP_QUICK_CMP_DEF(X, LT,  (144 + offs), t)   \
+    OP_QUICK_CMP_DEF(X, GT,  (148 + offs), t)   \
+    OP_QUICK_CMP_DEF(X, LE,  (152 + offs), t)   \
+    OP_QUICK_CMP_DEF(X, GE,  (156 + offs), t)
+
 enum OPCODE : uint8_t
 {
-#define X(name, code)   OP_##name = code,
+#define X(name, code)         OP_##name = code,
 OP_CODE_DEF(X)
+#undef X
+#define X(name, code, base)   OP_##name = code,
+OP_SPEC_CODE_DEF(X)
 #undef X
     END_OPCODE
 };
@@ -83,6 +199,10 @@ struct INST
     int8_t  ae;
     int8_t  be;
     int8_t  ce;
+#if WITH_COMPUTED_GOTO
+    // address of the handler in VM::eval(), see PROG::thread_code()
+    void   *handler;
+#endif
 
     static std::string regidx2string(int32_t i, int8_t e);
 
@@ -103,7 +223,9 @@ struct INST
     {
         AtomVec *av = gc.allocate_vector(9);
         av->m_len = 9;
-        av->m_data[0] = Atom(T_KW, gc.new_symbol(get_op_name()));
+        // Specialized instructions are written as their generic
+        // variant, PROG::specialize() redoes the work on load.
+        av->m_data[0] = Atom(T_KW, gc.new_symbol(op_name(base_op(op))));
         av->m_data[1].set_int(o);
         av->m_data[2].set_int(oe);
         av->m_data[3].set_int(a);
@@ -117,23 +239,38 @@ struct INST
 
     static uint8_t op_from_name(const std::string &opname)
     {
-#       define X(name, code)    if ((opname) == #name) { return code; } else
+#       define X(name, code)        if ((opname) == #name) { return code; } else
+#       define XS(name, code, base) X(name, code)
         OP_CODE_DEF(X)
+        OP_SPEC_CODE_DEF(XS)
         {
             return -1;
         }
+#       undef XS
 #       undef X
     }
 
-    std::string get_op_name() const
+    static std::string op_name(uint8_t op)
     {
         std::string op_name;
-#       define X(name, code)    case code: op_name = #name; break;
-        switch (op) { OP_CODE_DEF(X) }
+#       define X(name, code)        case code: op_name = #name; break;
+#       define XS(name, code, base) X(name, code)
+        switch (op) { OP_CODE_DEF(X) OP_SPEC_CODE_DEF(XS) }
+#       undef XS
 #       undef X
         return op_name;
     }
 
+    static uint8_t base_op(uint8_t op)
+    {
+#       define X(name, code, base)  case code: return OP_##base;
+        switch (op) { OP_SPEC_CODE_DEF(X) }
+#       undef X
+        return op;
+    }
+
+    std::string get_op_name() const { return op_name(op); }
+
     INST() { clear(); }
     void clear()
     {
@@ -146,6 +283,9 @@ struct INST
         ae = 0;
         be = 0;
         ce = 0;
+#if WITH_COMPUTED_GOTO
+        handler = nullptr;
+#endif
 //        va.i = 0;
     }
 };
@@ -163,18 +303,29 @@ class PROG : public UserData
         size_t   m_instructions_len;
         std::string m_function_info;
         GC      *m_gc;
+        bool     m_threaded;
+        // Minimum lengths of the frame and root register rows,
+        // that the instructions of this PROG may access:
+        size_t   m_frame_size;
+        size_t   m_root_size;
+        // Number of superinstructions specialize() has fused:
+        size_t   m_fused_count;
 
     public:
         static Atom create_prog_from_info(GC &gc, Atom prog_info, AtomMap *refmap = nullptr);
         static Atom repack_expanded_userdata(GC &gc, Atom a, AtomMap *refmap);
 
         PROG()
-            : m_instructions(nullptr), m_gc(nullptr), m_instructions_len(0)
+            : m_data_vec(nullptr), m_root_regs(nullptr),
+              m_instructions(nullptr), m_gc(nullptr), m_instructions_len(0),
+              m_threaded(false), m_frame_size(0), m_root_size(0),
+              m_fused_count(0)
         {
 //            std::cout << "*NEW PROG" << ((void *) this) << std::endl;
         }
         PROG(GC &gc, size_t atom_data_len, size_t instr_len)
-            : m_gc(&gc)
+            : m_root_regs(nullptr), m_gc(&gc), m_threaded(false),
+              m_frame_size(0), m_root_size(0), m_fused_count(0)
         {
             m_atom_data.set_vec(gc.allocate_vector(atom_data_len));
             m_data_vec = m_atom_data.m_d.vec;
@@ -189,11 +340,14 @@ class PROG : public UserData
 
         std::string func_info_at(INST *pc, Atom &info);
 
+        void specialize();
+        std::string disassemble();
+
         virtual void to_atom(Atom &a)
         {
             AtomVec *av = m_gc->allocate_vector(6);
             av->m_data[0] = Atom(T_SYM, m_gc->new_symbol("BKL-VM-PROG"));
-            av->m_data[1] = Atom(T_STR, m_gc->new_symbol(m_function_info));
+            av->m_data[1] = Atom(T_STR, m_gc->new_string(m_function_info));
             av->m_data[2] = m_atom_data;
 
             AtomVec *instr = m_gc->allocate_vector(m_instructions_len);
@@ -227,6 +381,17 @@ class PROG : public UserData
             m_instructions[idx] = i;
         }
 
+#if WITH_COMPUTED_GOTO
+        // Stores the handler address for each instruction (including
+        // the OP_END sentinel), handlers is indexed by the opcode.
+        void thread_code(void **handlers)
+        {
+            for (size_t i = 0; i <= m_instructions_len; i++)
+                m_instructions[i].handler = handlers[m_instructions[i].op];
+            m_threaded = true;
+        }
+#endif
+
         virtual std::string type() { return "BKL-VM-PROG"; }
         virtual std::string as_string(bool pretty = false);
 